@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2006 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+// Measures the VRC7 sound chip, one second of 44.1kHz audio at a time, under the
+// register traffic of a music driver. Not part of the core, build it against a
+// core library of the revision to time:
+//
+//   g++ -O2 -I source source/benchmark/vrc7.cpp libnst.a -lz -o vrc7
+//
+// For the per-slot implementation the operator arrays replaced, check out the
+// core from before them (git worktree add old ffb033e^) and link the same file
+// against a library built from there. Both print the same hash for the same
+// arguments, only the time differs.
+//
+// usage: vrc7 [passes] [channels]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "core/NstMapper.hpp"
+#include "core/NstClock.hpp"
+#include "core/board/NstBrdVrc4.hpp"
+#include "core/board/NstBrdVrc7.hpp"
+
+namespace
+{
+	using namespace Nes;
+	using namespace Nes::Core;
+
+	enum
+	{
+		SAMPLE_RATE = 44100,
+		FRAME_SAMPLES = SAMPLE_RATE / 60
+	};
+
+	class Chip : public Boards::Vrc7::Sound
+	{
+	public:
+
+		explicit Chip(Cpu& cpu)
+		: Sound(cpu,false), seed(0) {}
+
+		void Start(uint channels)
+		{
+			u8 volumes[MAX_CHANNELS];
+
+			for (uint i=0; i < MAX_CHANNELS; ++i)
+				volumes[i] = DEFAULT_VOLUME;
+
+			UpdateContext( 0, volumes );
+			Reset();
+
+			static const u8 custom[8] = {0x61,0x61,0x1E,0x17,0xF0,0x7F,0x00,0x17};
+
+			for (uint i=0; i < 8; ++i)
+				Poke( i, custom[i] );
+
+			active = channels;
+			seed = 12345;
+		}
+
+		void Frame(uint frame)
+		{
+			for (uint i=0; i < active; ++i)
+			{
+				const uint beat = (frame + i) % (8 + i);
+
+				if (beat == 0)
+				{
+					Poke( 0x30 + i, (Random() % 16) << 4 | Random() % 16 );
+					Poke( 0x10 + i, Random() & 0xFF );
+					Poke( 0x20 + i, 0x10 | (Random() & 0x2F) );
+				}
+				else if (beat == 5)
+				{
+					Poke( 0x20 + i, Random() & 0x2F );
+				}
+			}
+
+			if (frame % 50 == 7)
+				Poke( Random() % 8, Random() & 0xFF );
+		}
+
+		Sample Next()
+		{
+			return GetSample();
+		}
+
+	private:
+
+		void Poke(uint address,uint data)
+		{
+			WriteReg0( address );
+			WriteReg1( data );
+		}
+
+		uint Random()
+		{
+			seed = seed * 1103515245 + 12345;
+			return seed >> 16 & 0x7FFF;
+		}
+
+		uint active;
+		dword seed;
+	};
+
+	Apu::Sample samples[SAMPLE_RATE];
+
+	void Render(Chip& chip,uint channels)
+	{
+		chip.Start( channels );
+
+		for (uint i=0; i < SAMPLE_RATE; ++i)
+		{
+			if (i % FRAME_SAMPLES == 0)
+				chip.Frame( i / FRAME_SAMPLES );
+
+			samples[i] = chip.Next();
+		}
+	}
+
+	dword Hash()
+	{
+		dword hash = 0x811C9DC5;
+
+		for (uint i=0; i < SAMPLE_RATE; ++i)
+		{
+			const uint sample = samples[i] & 0xFFFF;
+
+			hash = ((hash ^ (sample & 0xFF)) * 0x01000193) & 0xFFFFFFFF;
+			hash = ((hash ^ (sample >> 8)) * 0x01000193) & 0xFFFFFFFF;
+		}
+
+		return hash;
+	}
+}
+
+int main(int argc,char** argv)
+{
+	const int passes = (argc > 1 ? std::atoi( argv[1] ) : 200);
+	const int channels = (argc > 2 ? std::atoi( argv[2] ) : 6);
+
+	if (passes < 1 || channels < 0 || channels > 6)
+	{
+		std::printf( "usage: vrc7 [passes] [channels 0-6]\n" );
+		return 1;
+	}
+
+	static Cpu cpu;
+	static Chip chip( cpu );
+
+	// first pass warms the tables and gives the output to compare
+
+	Render( chip, channels );
+	const Nes::dword hash = Hash();
+
+	const std::clock_t start = std::clock();
+
+	for (int i=0; i < passes; ++i)
+		Render( chip, channels );
+
+	const double elapsed = double(std::clock() - start) / CLOCKS_PER_SEC;
+
+	std::printf
+	(
+		"vrc7: %d channels, hash %08lx, %.3f ms per second of audio\n",
+		channels,
+		static_cast<unsigned long>(hash),
+		elapsed * 1000 / passes
+	);
+
+	return 0;
+}
@@ -23,6 +23,7 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include <cstdlib>
+#include <cstring>
 #include "NstState.hpp"
 #include "NstSignedArithmetic.hpp"
 #include "NstCpu.hpp"
@@ -170,12 +171,76 @@ namespace Nes
 			}
 		};
 
+		const u8 Apu::Square::steps[4][8] =
+		{
+			{0x1F,0x00,0x1F,0x1F,0x1F,0x1F,0x1F,0x1F},
+			{0x1F,0x00,0x00,0x1F,0x1F,0x1F,0x1F,0x1F},
+			{0x1F,0x00,0x00,0x00,0x00,0x1F,0x1F,0x1F},
+			{0x00,0x1F,0x1F,0x00,0x00,0x00,0x00,0x00}
+		};
+
+		const u8 Apu::Triangle::steps[32] =
+		{
+			0x0,0x1,0x2,0x3,0x4,0x5,0x6,0x7,0x8,0x9,0xA,0xB,0xC,0xD,0xE,0xF,
+			0xF,0xE,0xD,0xC,0xB,0xA,0x9,0x8,0x7,0x6,0x5,0x4,0x3,0x2,0x1,0x0
+		};
+
+		struct Apu::Synth
+		{
+			Synth();
+
+			bool SetRate(Mode,dword,uint);
+			void Reset(Cycle);
+
+			ibool enabled;
+			Cycle clock;
+			uint extLength;
+			Sample last;
+			dword dac[2];
+			dword output[2];
+			Sound::StepBuffer steps;
+			Sample ext[Sound::StepBuffer::SIZE];
+		};
+
 		#ifdef NST_PRAGMA_OPTIMIZE
 		#pragma optimize("s", on)
 		#endif
 
+		Apu::Synth::Synth()
+		: enabled(false)
+		{
+			Reset( 0 );
+		}
+
+		bool Apu::Synth::SetRate(const Mode mode,const dword rate,const uint speed)
+		{
+			// steps land on the output grid directly, so the speed
+			// setting can only be honoured by shifting the pitch too
+
+			const uint fps = (mode == MODE_NTSC ? FPS_NTSC : FPS_PAL);
+			const uint div = (mode == MODE_NTSC ? Cpu::CLK_NTSC_DIV : Cpu::CLK_PAL_DIV);
+			const dword clocks = (mode == MODE_NTSC ? Cpu::MC_NTSC : Cpu::MC_PAL);
+
+			const qword samples = (speed ? qword(rate) * fps / speed : rate) * div;
+			const Cycle frame = clocks / (div * fps) * 2;
+
+			return steps.SetRate( samples, clocks, frame );
+		}
+
+		void Apu::Synth::Reset(const Cycle c)
+		{
+			clock = c;
+			extLength = 0;
+			last = 0;
+
+			dac[0] = dac[1] = 0;
+			output[0] = output[1] = 0;
+
+			steps.Reset();
+		}
+
 		Apu::Context::Context()
-		: rate(44100U), bits(16), speed(0), transpose(false), stereo(false), audible(true)
+		: rate(44100U), bits(16), speed(0), transpose(false), stereo(false), audible(true), bandLimiting(false), stems(false), rateControl(false), rateAdjustment(0)
 		{
 			for (uint i=0; i < MAX_CHANNELS; ++i)
 				volumes[i] = DEFAULT_VOLUME;
@@ -242,6 +307,14 @@ namespace Nes
 			next = prev = acc = 0;
 		}
 
+		void Apu::Stems::Reset()
+		{
+			count = 0;
+
+			for (uint i=0; i < CHANNEL_DPCM+1; ++i)
+				dcBlockers[i].Reset();
+		}
+
 		void Apu::Envelope::Reset()
 		{
 			output = 0;
@@ -260,13 +333,15 @@ namespace Nes
 		cpu        (*c),
 		mode       (MODE_NTSC),
 		extChannel (NULL),
-		buffer     (*new Sound::Buffer(16))
+		buffer     (*new Sound::Buffer(16)),
+		synth      (NULL)
 		{
 			UpdateSettings();
 		}
 
 		Apu::~Apu()
 		{
+			delete synth;
 			delete &buffer;
 		}
 
@@ -294,6 +369,7 @@ namespace Nes
 
 			cycles.Reset( mode );
 			dcBlocker.Reset();
+			stems.Reset();
 			buffer.Reset( context.bits );
 
 			if (hard)
@@ -359,7 +435,7 @@ namespace Nes
 			if (context.bits == bits)
 				return RESULT_NOP;
 
-			if (bits != 8 && bits != 16)
+			if (bits != 8 && bits != 16 && bits != 32)
 				return RESULT_ERR_UNSUPPORTED;
 
 			context.bits = bits;
@@ -438,6 +514,63 @@ namespace Nes
 			}
 		}
 
+		Result Apu::SetBandLimiting(const bool enable)
+		{
+			if (context.bandLimiting == enable)
+				return RESULT_NOP;
+
+			if (enable && !synth)
+				synth = new Synth;
+
+			context.bandLimiting = enable;
+			UpdateSettings();
+
+			if (enable && !context.stems && !synth->enabled)
+			{
+				context.bandLimiting = false;
+				UpdateSettings();
+
+				return RESULT_ERR_UNSUPPORTED;
+			}
+
+			return RESULT_OK;
+		}
+
+		void Apu::SetStemOutput(const bool enable)
+		{
+			if (context.stems != enable)
+			{
+				context.stems = enable;
+				UpdateSettings();
+			}
+		}
+
+		void Apu::SetRateControl(const bool enable)
+		{
+			if (context.rateControl != enable)
+			{
+				context.rateControl = enable;
+				UpdateSettings();
+			}
+		}
+
+		Result Apu::SetRateAdjustment(const idword ppm)
+		{
+			// in parts per million of the sample rate, a positive
+			// adjustment stretches each frame into more samples
+
+			if (context.rateAdjustment == ppm)
+				return RESULT_NOP;
+
+			if (ppm < -5000 || ppm > 5000)
+				return RESULT_ERR_INVALID_PARAM;
+
+			context.rateAdjustment = ppm;
+			buffer.SetRateAdjustment( ppm );
+
+			return RESULT_OK;
+		}
+
 		void Apu::CalculateOscillatorClock(Cycle& rate,Cycle& fixed) const
 		{
 			dword sampleRate = context.rate;
@@ -469,15 +602,31 @@ namespace Nes
 		{
 			cycles.Update( context.rate, context.speed, mode );
 			dcBlocker.Reset();
+			stems.Reset();
 			buffer.Reset( context.bits );
 
 			Cycle rate, fixed;
 			CalculateOscillatorClock( rate, fixed );
 
-			square[0].SetContext ( rate, fixed, (context.volumes[ CHANNEL_SQUARE1  ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME       );
-			square[1].SetContext ( rate, fixed, (context.volumes[ CHANNEL_SQUARE2  ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME       );
-			triangle.SetContext  ( rate, fixed, (context.volumes[ CHANNEL_TRIANGLE ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME       );
-			noise.SetContext     ( rate, fixed, (context.volumes[ CHANNEL_NOISE    ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME, mode );
+			Cycle oscillator = fixed;
+
+			if (synth)
+			{
+				// the stems are point sampled, band-limiting waits until they're off
+
+				synth->enabled = context.bandLimiting && !context.stems && synth->SetRate( mode, context.rate, context.speed );
+				synth->Reset( cpu.GetMasterClockCycles() );
+
+				// stepped oscillators run on the cpu master clock
+
+				if (synth->enabled)
+					oscillator = (mode == MODE_NTSC ? Cpu::MC_DIV_NTSC : Cpu::MC_DIV_PAL);
+			}
+
+			square[0].SetContext ( rate, oscillator, (context.volumes[ CHANNEL_SQUARE1  ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME       );
+			square[1].SetContext ( rate, oscillator, (context.volumes[ CHANNEL_SQUARE2  ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME       );
+			triangle.SetContext  ( rate, oscillator, (context.volumes[ CHANNEL_TRIANGLE ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME       );
+			noise.SetContext     ( rate, oscillator, (context.volumes[ CHANNEL_NOISE    ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME, mode );
 			dmc.SetContext       (              (context.volumes[ CHANNEL_DPCM     ] * OUTPUT_MUL + DEFAULT_VOLUME/2) / DEFAULT_VOLUME, mode );
 
 			context.audible =
@@ -508,10 +657,43 @@ namespace Nes
 		{
 			stream = s;
 
+			stems.enabled = stream && context.stems;
+			stems.count = 0;
+
 			if (stream && context.audible)
-				updater = &Apu::SyncOn;
+			{
+				if (synth && synth->enabled)
+				{
+					if (updater != &Apu::SyncStepped)
+						synth->Reset( cpu.GetMasterClockCycles() );
+
+					updater = &Apu::SyncStepped;
+				}
+				else
+				{
+					updater = &Apu::SyncOn;
+				}
+			}
 			else
+			{
 				updater = &Apu::SyncOff;
+			}
+		}
+
+		bool Apu::IsSynthRunning() const
+		{
+			return updater == &Apu::SyncStepped;
+		}
+
+		void Apu::ResumeSynth()
+		{
+			// picks up where the synth stopped, only valid once the state
+			// it stopped at has been loaded back with nothing run in between
+			// that wasn't left silent
+
+			NST_ASSERT( synth && synth->enabled );
+
+			updater = &Apu::SyncStepped;
 		}
 
 		inline bool Apu::NoFrameClockCollision() const
@@ -531,57 +713,76 @@ namespace Nes
 
 		void Apu::EndFrame()
 		{
-			if (stream && context.audible && Sound::Output::lockCallback( *stream ))
+			if (updater == &Apu::SyncStepped)
+			{
+				Update();
+				RenderSteps();
+			}
+
+			Sound::Output* target = NULL;
+			Sound::Output ring;
+
+			if (stream && context.audible)
+			{
+				if (context.rateControl)
+					buffer.UpdateRate();
+
+				if (stream->ring)
+				{
+					// hand over exactly what the frame produced
+
+					Update();
+
+					if (stream->ring->Reserve( ring, context.rateControl ? buffer.ResampledLatency() : buffer.Latency(), context.bits, context.stereo ))
+						target = &ring;
+				}
+				else if (Sound::Output::lockCallback( *stream ))
+				{
+					target = stream;
+				}
+			}
+
+			if (target)
 			{
 				for (uint i=0; i < 2; ++i)
 				{
-					if (stream->length[i])
+					if (target->length[i])
 					{
-						Sound::Buffer::Block block( stream->length[i] );
-						buffer >> block;
-
-						if (context.bits == 16)
+						if (context.bits == 32)
 						{
 							if (context.stereo)
-							{
-								Sound::Buffer::Renderer<i16,true> output(stream->samples[i],stream->length[i],buffer.history);
-
-								if (output << block)
-									UpdateBuffer( output );
-							}
+								Flush( Sound::Buffer::Renderer<float,true>(target->samples[i],target->length[i],buffer.history) );
 							else
-							{
-								Sound::Buffer::Renderer<i16,false> output(stream->samples[i],stream->length[i]);
-
-								if (output << block)
-									UpdateBuffer( output );
-							}
+								Flush( Sound::Buffer::Renderer<float,false>(target->samples[i],target->length[i]) );
+						}
+						else if (context.bits == 16)
+						{
+							if (context.stereo)
+								Flush( Sound::Buffer::Renderer<i16,true>(target->samples[i],target->length[i],buffer.history) );
+							else
+								Flush( Sound::Buffer::Renderer<i16,false>(target->samples[i],target->length[i]) );
 						}
 						else
 						{
 							if (context.stereo)
-							{
-								Sound::Buffer::Renderer<u8,true> output(stream->samples[i],stream->length[i],buffer.history);
-
-								if (output << block)
-									UpdateBuffer( output );
-							}
+								Flush( Sound::Buffer::Renderer<u8,true>(target->samples[i],target->length[i],buffer.history) );
 							else
-							{
-								Sound::Buffer::Renderer<u8,false> output(stream->samples[i],stream->length[i]);
-
-								if (output << block)
-									UpdateBuffer( output );
-							}
+								Flush( Sound::Buffer::Renderer<u8,false>(target->samples[i],target->length[i]) );
 						}
 					}
 				}
 
-				Sound::Output::unlockCallback( *stream );
+				if (target == stream)
+					Sound::Output::unlockCallback( *stream );
+				else
+					stream->ring->Commit( ring );
 			}
 
 			Update();
 
+			if (stems.enabled)
+				stream->stemCount = stems.count;
+
 			const Cycle frame = cpu.GetMasterClockFrameCycles();
 
 			Clock( frame );
@@ -607,6 +808,12 @@ namespace Nes
 				cycles.frameIrqClock -= frame;
 
 			cycles.dmcClock -= frame;
+
+			if (updater == &Apu::SyncStepped)
+			{
+				NST_VERIFY( synth->clock >= frame );
+				synth->clock -= frame;
+			}
 		}
 
 		#ifdef NST_PRAGMA_OPTIMIZE
@@ -631,7 +838,11 @@ namespace Nes
 			noise.ClearAmp();
 			dmc.ClearAmp();
 
+			if (synth)
+				synth->Reset( cpu.GetMasterClockCycles() );
+
 			dcBlocker.Reset();
+			stems.Reset();
 			buffer.Reset( context.bits, false );
 		}
 
@@ -692,6 +903,23 @@ namespace Nes
 			rate = r;
 		}
 
+		void Apu::Oscillator::SaveClock(State::Saver& state,const uint step) const
+		{
+			NST_VERIFY( timer >= 0 );
+
+			state.Begin('C','L','K','\0').Write32( timer ).Write32( fixed ).Write16( step ).End();
+		}
+
+		uint Apu::Oscillator::LoadClock(State::Loader& state)
+		{
+			const dword count = state.Read32();
+			const dword scale = state.Read32();
+
+			timer = scale ? iword(count / scale * fixed + count % scale * fixed / scale) : 0;
+
+			return state.Read16();
+		}
+
 		void Apu::Dmc::SetContext(uint v,Mode m)
 		{
 			mode = m;
@@ -1123,14 +1351,6 @@ namespace Nes
 
 			if (active)
 			{
-				static const u8 steps[4][8] =
-				{
-					{0x1F,0x00,0x1F,0x1F,0x1F,0x1F,0x1F,0x1F},
-					{0x1F,0x00,0x00,0x1F,0x1F,0x1F,0x1F,0x1F},
-					{0x1F,0x00,0x00,0x00,0x00,0x1F,0x1F,0x1F},
-					{0x00,0x1F,0x1F,0x00,0x00,0x00,0x00,0x00}
-				};
-
 				if (timer >= 0)
 				{
 					amp = dword(envelope.Volume()) >> steps[duty][step];
@@ -1177,12 +1397,6 @@ namespace Nes
 
 			if (active)
 			{
-				static const u8 steps[32] =
-				{
-					0x0,0x1,0x2,0x3,0x4,0x5,0x6,0x7,0x8,0x9,0xA,0xB,0xC,0xD,0xE,0xF,
-					0xF,0xE,0xD,0xC,0xB,0xA,0x9,0x8,0x7,0x6,0x5,0x4,0x3,0x2,0x1,0x0
-				};
-
 				dword sum = timer;
 				timer -= iword(rate);
 
@@ -1401,6 +1615,12 @@ namespace Nes
 			return Cycles::frameClocks[mode][ctrl >> 7][cycles.frameDivider] * cycles.fixed;
 		}
 
+		inline void Apu::Dmc::Skip(const Cycle ticks)
+		{
+			NST_VERIFY( IsIdle() );
+			out.shifter = ((out.shifter - 1 - ticks) & 0x7) + 1;
+		}
+
 		inline uint Apu::Dmc::SetSample(const uint value)
 		{
 			const uint old = curSample;
@@ -1439,6 +1659,22 @@ namespace Nes
 				}
 
 				cycles.dmcClock += dmc.GetFrequency();
+
+				if (dmc.IsIdle())
+				{
+					// Nothing but the bit counter turns until the channel
+					// gets enabled again. Skip over the rest all at once.
+
+					if (cycles.dmcClock <= target)
+					{
+						const Cycle ticks = (target - cycles.dmcClock) / dmc.GetFrequency() + 1;
+
+						dmc.Skip( ticks );
+						cycles.dmcClock += ticks * dmc.GetFrequency();
+					}
+
+					break;
+				}
 			}
 			while (cycles.dmcClock <= target);
 		}
@@ -1460,7 +1696,7 @@ namespace Nes
 			}
 		}
 
-		Apu::Sample Apu::GetSample()
+		inline Apu::Sample Apu::Mix(const Sample ext)
 		{
 			dword dac[2];
 
@@ -1468,14 +1704,134 @@ namespace Nes
 			(
 				(0 != (dac[0] = square[0].GetSample() + square[1].GetSample()) ? dword(NLN_SQ_0) / (dword(NLN_SQ_1) / dac[0] + NLN_SQ_2) : 0) +
 				(0 != (dac[1] = triangle.GetSample() + noise.GetSample() + dmc.GetSample()) ? dword(NLN_TND_0) / (dword(NLN_TND_1) / dac[1] + NLN_TND_2) : 0)
-			) + (extChannel ? extChannel->GetSample() : 0);
+			) + ext;
+
+			return (sample <= OUTPUT_MAX) ? (sample >= OUTPUT_MIN) ? sample : OUTPUT_MIN : OUTPUT_MAX;
+		}
+
+		Apu::Sample Apu::GetSample()
+		{
+			if (stems.enabled)
+				return GetStemSample();
+
+			return Mix( extChannel ? extChannel->GetSample() : 0 );
+		}
+
+		Apu::Sample Apu::Channel::GetStems(Sample (&)[MAX_CHANNELS])
+		{
+			return GetSample();
+		}
+
+		Cycle Apu::Channel::Render(Sample* const output,const uint length,Cycle clock,const Cycle period,Cycle next)
+		{
+			// Renders the samples due at clock, clock + period, clock + period * 2 ..
+			// and calls Clock() whenever the next clock is passed on the way, the
+			// same as the per-sample loops in the Apu. The chips override this
+			// with a loop of their own that doesn't go through the vtable.
+
+			for (uint i=0; i < length; ++i)
+			{
+				output[i] = GetSample();
+
+				while (next <= clock)
+					next += Clock();
+
+				clock += period;
+			}
+
+			return next;
+		}
+
+		template<typename T>
+		void Apu::SyncBlocks(T& output,const Cycle target,uint space)
+		{
+			// The expansion sound doesn't depend on anything the internal
+			// channels do, so it's rendered ahead one block at a time and
+			// then mixed in sample by sample.
+
+			Sample ext[Channel::BLOCK_SIZE];
+
+			while (cycles.rateCounter < target && space)
+			{
+				uint length = (target - cycles.rateCounter - 1) / cycles.rate + 1;
+
+				if (length > space)
+					length = space;
+
+				if (length > Channel::BLOCK_SIZE)
+					length = Channel::BLOCK_SIZE;
+
+				space -= length;
+				cycles.extCounter = extChannel->Render( ext, length, cycles.rateCounter, cycles.rate, cycles.extCounter );
+
+				for (uint i=0; i < length; ++i)
+				{
+					output << Mix( ext[i] );
+
+					if (cycles.frameCounter <= cycles.rateCounter)
+						cycles.frameCounter += ClockOscillators();
+
+					cycles.rateCounter += cycles.rate;
+				}
+			}
+		}
+
+		Apu::Sample Apu::GetStemSample()
+		{
+			// Same mix as GetSample() but with every channel also run through
+			// the DAC on its own, as if all the others had been muted.
+
+			const dword levels[] =
+			{
+				square[0].GetSample(),
+				square[1].GetSample(),
+				triangle.GetSample(),
+				noise.GetSample(),
+				dmc.GetSample()
+			};
+
+			Sample channels[MAX_CHANNELS];
+			dword dac[2];
+
+			for (uint i=0; i < NUM_SQUARES; ++i)
+				channels[i] = stems.dcBlockers[i].Apply( levels[i] ? dword(NLN_SQ_0) / (dword(NLN_SQ_1) / levels[i] + NLN_SQ_2) : 0 );
+
+			for (uint i=NUM_SQUARES; i < CHANNEL_DPCM+1; ++i)
+				channels[i] = stems.dcBlockers[i].Apply( levels[i] ? dword(NLN_TND_0) / (dword(NLN_TND_1) / levels[i] + NLN_TND_2) : 0 );
+
+			for (uint i=CHANNEL_DPCM+1; i < MAX_CHANNELS; ++i)
+				channels[i] = 0;
+
+			Sample sample = dcBlocker.Apply
+			(
+				(0 != (dac[0] = levels[0] + levels[1]) ? dword(NLN_SQ_0) / (dword(NLN_SQ_1) / dac[0] + NLN_SQ_2) : 0) +
+				(0 != (dac[1] = levels[2] + levels[3] + levels[4]) ? dword(NLN_TND_0) / (dword(NLN_TND_1) / dac[1] + NLN_TND_2) : 0)
+			);
+
+			if (extChannel)
+				sample += extChannel->GetStems( channels );
+
+			if (stems.count < stream->stemLength)
+			{
+				for (uint i=0; i < MAX_CHANNELS; ++i)
+				{
+					if (i16* const output = stream->stems[i])
+						output[stems.count] = (channels[i] <= OUTPUT_MAX) ? (channels[i] >= OUTPUT_MIN) ? channels[i] : OUTPUT_MIN : OUTPUT_MAX;
+				}
+
+				++stems.count;
+			}
 
 			return (sample <= OUTPUT_MAX) ? (sample >= OUTPUT_MIN) ? sample : OUTPUT_MIN : OUTPUT_MAX;
 		}
 
 		void Apu::SyncOn(const Cycle target)
 		{
-			while (cycles.rateCounter < target)
+			if (extChannel && !stems.enabled)
+			{
+				SyncBlocks( buffer, target, ~0U );
+			}
+			else while (cycles.rateCounter < target)
 			{
 				buffer << GetSample();
 
@@ -1508,6 +1864,269 @@ namespace Nes
 				cycles.extCounter += extChannel->Clock();
 		}
 
+		NST_FORCE_INLINE Cycle Apu::Square::Step()
+		{
+			step = (step + 1) & 0x7;
+			return frequency;
+		}
+
+		NST_FORCE_INLINE dword Apu::Square::GetLevel() const
+		{
+			return dword(active ? envelope.Volume() : 0) >> steps[duty][step];
+		}
+
+		NST_FORCE_INLINE Cycle Apu::Triangle::Step()
+		{
+			step = (step + 1) & 0x1F;
+			return frequency;
+		}
+
+		NST_FORCE_INLINE dword Apu::Triangle::GetLevel() const
+		{
+			// a halted sequencer holds its last step
+
+			return steps[step] * outputVolume * 3;
+		}
+
+		NST_FORCE_INLINE Cycle Apu::Noise::Step()
+		{
+			bits = (bits << 1) | (((bits >> 14) ^ (bits >> shifter)) & 0x1);
+			return frequency;
+		}
+
+		NST_FORCE_INLINE dword Apu::Noise::GetLevel() const
+		{
+			return (active && !(bits & 0x4000U)) ? envelope.Volume() * 2 : 0;
+		}
+
+		inline void Apu::Oscillator::SetStepClock(const Cycle next,const Cycle clock)
+		{
+			if (next != NES_CYCLE_MAX)
+				timer = next - clock;
+		}
+
+		inline Cycle Apu::Square::GetStepClock(const Cycle clock,const Cycle end)
+		{
+			NST_VERIFY( timer >= 0 );
+
+			Cycle next = clock + timer;
+
+			if (active)
+				return next;
+
+			// silent, only the sequencer position is kept up
+
+			if (next < end)
+			{
+				const Cycle count = (end - next + frequency - 1) / frequency;
+
+				step = (step + count) & 0x7;
+				next += count * frequency;
+			}
+
+			timer = next - end;
+
+			return NES_CYCLE_MAX;
+		}
+
+		inline Cycle Apu::Triangle::GetStepClock(const Cycle clock,Cycle) const
+		{
+			NST_VERIFY( timer >= 0 );
+
+			return active ? clock + timer : NES_CYCLE_MAX;
+		}
+
+		inline Cycle Apu::Noise::GetStepClock(const Cycle clock,const Cycle end)
+		{
+			NST_VERIFY( timer >= 0 );
+
+			Cycle next = clock + timer;
+
+			if (active)
+				return next;
+
+			// silent, but the shift register must still be clocked
+
+			for (; next < end; next += frequency)
+				bits = (bits << 1) | (((bits >> 14) ^ (bits >> shifter)) & 0x1);
+
+			timer = next - end;
+
+			return NES_CYCLE_MAX;
+		}
+
+		inline void Apu::StepSquares(const Cycle clock)
+		{
+			Synth& s = *synth;
+			const dword dac = square[0].GetLevel() + square[1].GetLevel();
+
+			if (s.dac[0] != dac)
+			{
+				s.dac[0] = dac;
+
+				const dword output = dac ? dword(NLN_SQ_0) / (dword(NLN_SQ_1) / dac + NLN_SQ_2) : 0;
+				s.steps.Add( clock, idword(output) - idword(s.output[0]) );
+				s.output[0] = output;
+			}
+		}
+
+		inline void Apu::StepTnd(const Cycle clock)
+		{
+			Synth& s = *synth;
+			const dword dac = triangle.GetLevel() + noise.GetLevel() + dmc.CheckSample();
+
+			if (s.dac[1] != dac)
+			{
+				s.dac[1] = dac;
+
+				const dword output = dac ? dword(NLN_TND_0) / (dword(NLN_TND_1) / dac + NLN_TND_2) : 0;
+				s.steps.Add( clock, idword(output) - idword(s.output[1]) );
+				s.output[1] = output;
+			}
+		}
+
+		void Apu::Synthesize(const Cycle clock)
+		{
+			// The channels of each group are stepped in time order so that
+			// the nonlinear DAC sees their sum exactly as the hardware does.
+			// Shaping the steps before they're band-limited rather than the
+			// samples after keeps the curve from adding harmonics of its own.
+
+			Synth& s = *synth;
+
+			if (s.clock < clock)
+			{
+				StepSquares( s.clock );
+				StepTnd( s.clock );
+
+				Cycle next[2] =
+				{
+					square[0].GetStepClock( s.clock, clock ),
+					square[1].GetStepClock( s.clock, clock )
+				};
+
+				for (;;)
+				{
+					const Cycle step = NST_MIN(next[0],next[1]);
+
+					if (step >= clock)
+						break;
+
+					if (next[0] == step)
+						next[0] += square[0].Step();
+
+					if (next[1] == step)
+						next[1] += square[1].Step();
+
+					StepSquares( step );
+				}
+
+				square[0].SetStepClock( next[0], clock );
+				square[1].SetStepClock( next[1], clock );
+
+				next[0] = triangle.GetStepClock( s.clock, clock );
+				next[1] = noise.GetStepClock( s.clock, clock );
+
+				for (;;)
+				{
+					const Cycle step = NST_MIN(next[0],next[1]);
+
+					if (step >= clock)
+						break;
+
+					if (next[0] == step)
+						next[0] += triangle.Step();
+
+					if (next[1] == step)
+						next[1] += noise.Step();
+
+					StepTnd( step );
+				}
+
+				triangle.SetStepClock( next[0], clock );
+				noise.SetStepClock( next[1], clock );
+
+				s.clock = clock;
+			}
+		}
+
+		void Apu::SyncStepped(const Cycle target)
+		{
+			// Every level change goes into the step buffer at the exact
+			// master clock it happens on. Only the expansion sound, being
+			// mixed on its own, is still sampled at the output rate.
+
+			while (cycles.frameCounter < target)
+			{
+				Synthesize( cycles.frameCounter / cycles.fixed );
+				cycles.frameCounter += ClockOscillators();
+			}
+
+			Synthesize( target / cycles.fixed );
+
+			if (extChannel)
+			{
+				Synth& s = *synth;
+
+				if (cycles.rateCounter < target && s.extLength < Sound::StepBuffer::SIZE)
+				{
+					uint length = (target - cycles.rateCounter - 1) / cycles.rate + 1;
+
+					if (length > Sound::StepBuffer::SIZE - s.extLength)
+						length = Sound::StepBuffer::SIZE - s.extLength;
+
+					cycles.extCounter = extChannel->Render( s.ext + s.extLength, length, cycles.rateCounter, cycles.rate, cycles.extCounter );
+					cycles.rateCounter += length * cycles.rate;
+					s.extLength += length;
+				}
+
+				while (cycles.rateCounter < target)
+				{
+					while (cycles.extCounter <= cycles.rateCounter)
+						cycles.extCounter += extChannel->Clock();
+
+					cycles.rateCounter += cycles.rate;
+				}
+
+				while (cycles.extCounter < target)
+					cycles.extCounter += extChannel->Clock();
+			}
+			else
+			{
+				cycles.rateCounter = target;
+			}
+		}
+
+		void Apu::RenderSteps()
+		{
+			Synth& s = *synth;
+
+			const uint count = s.steps.EndFrame( cpu.GetMasterClockFrameCycles() );
+
+			for (uint i=0; i < count; ++i)
+			{
+				Sample sample = dcBlocker.Apply( s.steps[i] );
+
+				if (s.extLength)
+					sample += s.ext[NST_MIN(i,s.extLength-1)];
+
+				s.last = sample = (sample <= OUTPUT_MAX) ? (sample >= OUTPUT_MIN) ? sample : OUTPUT_MIN : OUTPUT_MAX;
+				buffer << sample;
+			}
+
+			s.steps.Remove( count );
+
+			if (s.extLength > count)
+			{
+				s.extLength -= count;
+				std::memmove( s.ext, s.ext + count, sizeof(Sample) * s.extLength );
+			}
+			else
+			{
+				s.extLength = 0;
+			}
+		}
+
 		inline uint Apu::Square::GetLengthCounter() const
 		{
 			return lengthCounter.GetCount();
@@ -1606,8 +2225,15 @@ namespace Nes
 			noise.WriteReg3( data, safe );
 		}
 
+		inline void Apu::SyncIdleDmc()
+		{
+			if (dmc.IsIdle() && cycles.dmcClock <= cpu.GetMasterClockCycles())
+				ClockDmc( cpu.GetMasterClockCycles() );
+		}
+
 		NES_POKE(Apu,4010)
 		{
+			SyncIdleDmc();
 			dmc.WriteReg0( data, cpu );
 		}
 
@@ -1635,7 +2261,12 @@ namespace Nes
 			square[1].Toggle ( data & ENABLE_SQUARE2  );
 			triangle.Toggle  ( data & ENABLE_TRIANGLE );
 			noise.Toggle     ( data & ENABLE_NOISE    );
-			dmc.Toggle       ( data & ENABLE_DMC, cpu );
+
+			SyncIdleDmc();
+			dmc.Toggle( data & ENABLE_DMC, cpu );
+
+			if (!dmc.IsIdle())
+				cpu.NextRound( cycles.dmcClock );
 		}
 
 		NES_PEEK(Apu,4015)
@@ -1719,11 +2350,52 @@ namespace Nes
 			return 0x40;
 		}
 
+		template<typename T>
+		void Apu::Flush(T output)
+		{
+			if (context.rateControl)
+			{
+				// whatever's missing is queued up first so that
+				// all of it goes through the same resampler
+
+				const uint length = buffer.ResamplerDemand( output.Length() );
+
+				if (length > buffer.Latency())
+					UpdateBuffer( Sound::Buffer::Writer(buffer,length - buffer.Latency()) );
+
+				buffer.Resample( output );
+			}
+			else
+			{
+				Sound::Buffer::Block block( output.Length() );
+				buffer >> block;
+
+				if (output << block)
+					UpdateBuffer( output );
+			}
+		}
+
 		template<typename T>
 		void Apu::UpdateBuffer(T output)
 		{
+			if (updater == &Apu::SyncStepped)
+			{
+				// the frame's samples have all been rendered
+
+				do
+				{
+					output << synth->last;
+				}
+				while (output);
+
+				return;
+			}
+
 			const Cycle target = cpu.GetMasterClockCycles() * cycles.fixed;
 
+			if (extChannel && !stems.enabled)
+				SyncBlocks( output, target, output.Length() );
+
 			while (cycles.rateCounter < target && output)
 			{
 				output << GetSample();
@@ -1789,6 +2461,18 @@ namespace Nes
 				state.Begin('F','R','M','\0').Write( data ).End();
 			}
 
+			{
+				// where the next output sample falls, older states line it up with the cpu
+
+				NST_VERIFY( cycles.rateCounter >= cpu.GetMasterClockCycles() * cycles.fixed );
+
+				state.Begin('S','M','P','\0').Write32( cycles.rateCounter - cpu.GetMasterClockCycles() * cycles.fixed ).Write32( cycles.rate ).End();
+			}
+
+			// the frame irq as it was rather than as derived from the sequencer
+
+			state.Begin('I','R','Q','\0').Write32( cycles.frameIrqClock ).Write8( cycles.frameIrqRepeat ).End();
+
 			square[0].SaveState( State::Saver::Subset(state,'S','Q','0','\0').Ref() );
 			square[1].SaveState( State::Saver::Subset(state,'S','Q','1','\0') .Ref());
 			triangle.SaveState( State::Saver::Subset(state,'T','R','I','\0').Ref() );
@@ -1833,6 +2517,26 @@ namespace Nes
 						break;
 					}
 
+					case NES_STATE_CHUNK_ID('I','R','Q','\0'):
+
+						cycles.frameIrqClock = state.Read32();
+						cycles.frameIrqRepeat = state.Read8() % 3;
+
+						if (ctrl)
+							cycles.frameIrqClock = NES_CYCLE_MAX;
+
+						break;
+
+					case NES_STATE_CHUNK_ID('S','M','P','\0'):
+					{
+						const dword offset = state.Read32();
+
+						if (state.Read32() == cycles.rate && offset < cycles.rate)
+							cycles.rateCounter = cpu.GetMasterClockCycles() * cycles.fixed + offset;
+
+						break;
+					}
+
 					case NES_STATE_CHUNK_ID('S','Q','0','\0'):
 
 						square[0].LoadState( State::Loader::Subset(state).Ref() );
@@ -1937,10 +2641,17 @@ namespace Nes
 
 			lengthCounter.SaveState( State::Saver::Subset(state,'L','E','N','\0').Ref() );
 			envelope.SaveState( State::Saver::Subset(state,'E','N','V','\0').Ref() );
+
+			// where the wave is at, older states start it over
+
+			SaveClock( state, step );
 		}
 
 		void Apu::Square::LoadState(State::Loader& state)
 		{
+			step = 0;
+			timer = 0;
+
 			while (const dword chunk = state.Begin())
 			{
 				switch (chunk)
@@ -1981,13 +2692,16 @@ namespace Nes
 
 						envelope.LoadState( State::Loader::Subset(state).Ref() );
 						break;
+
+					case NES_STATE_CHUNK_ID('C','L','K','\0'):
+
+						step = LoadClock( state ) & 0x7;
+						break;
 				}
 
 				state.End();
 			}
 
-			step = 0;
-			timer = 0;
 			active = UpdateFrequency();
 		}
 
@@ -2006,10 +2720,15 @@ namespace Nes
 			}
 
 			lengthCounter.SaveState( State::Saver::Subset(state,'L','E','N','\0').Ref() );
+
+			SaveClock( state, step );
 		}
 
 		void Apu::Triangle::LoadState(State::Loader& state)
 		{
+			timer = 0;
+			step = 0;
+
 			while (const dword chunk = state.Begin())
 			{
 				switch (chunk)
@@ -2031,13 +2750,16 @@ namespace Nes
 
 						lengthCounter.LoadState( State::Loader::Subset(state).Ref() );
 						break;
+
+					case NES_STATE_CHUNK_ID('C','L','K','\0'):
+
+						step = LoadClock( state ) & 0x1F;
+						break;
 				}
 
 				state.End();
 			}
 
-			timer = 0;
-			step = 0;
 			active = CanOutput();
 		}
 
@@ -2063,10 +2785,15 @@ namespace Nes
 
 			lengthCounter.SaveState( State::Saver::Subset(state,'L','E','N','\0').Ref() );
 			envelope.SaveState( State::Saver::Subset(state,'E','N','V','\0').Ref() );
+
+			SaveClock( state, bits & 0x7FFF );
 		}
 
 		void Apu::Noise::LoadState(State::Loader& state)
 		{
+			timer = 0;
+			bits = 1;
+
 			while (const dword chunk = state.Begin())
 			{
 				switch (chunk)
@@ -2089,13 +2816,20 @@ namespace Nes
 
 						envelope.LoadState( State::Loader::Subset(state).Ref() );
 						break;
+
+					case NES_STATE_CHUNK_ID('C','L','K','\0'):
+
+						bits = LoadClock( state ) & 0x7FFF;
+
+						if (!bits)
+							bits = 1;
+
+						break;
 				}
 
 				state.End();
 			}
 
-			timer = 0;
-			bits = 1;
 			active = CanOutput();
 		}
 
@@ -2111,7 +2845,7 @@ namespace Nes
 			u8 data[12] =
 			{
 				dmcClock & 0xFF,
-				dmcClock >> 16,
+				dmcClock >> 8,
 				(loop ? SAVE_2_LOOP : 0) | (cpu.IsLine(Cpu::IRQ_DMC) ? SAVE_2_IRQ : 0) | (dma.lengthCounter ? SAVE_2_ENABLED : 0),
 				(loadedAddress - 0xC000U) >> 6,
 				(loadedLengthCount - 1) >> 4,
@@ -2134,6 +2868,10 @@ namespace Nes
 			}
 
 			state.Begin('R','E','G','\0').Write( data ).End();
+
+			// the length above only goes in steps of 16 bytes
+
+			state.Begin('L','E','N','\0').Write16( dma.lengthCounter ).End();
 		}
 
 		void Apu::Dmc::LoadState(State::Loader& state,Cpu& cpu,Cycle& dmcClock)
@@ -2167,6 +2905,16 @@ namespace Nes
 						active = dma.buffered && outputVolume;
 						break;
 					}
+
+					case NES_STATE_CHUNK_ID('L','E','N','\0'):
+
+						if (dma.lengthCounter)
+						{
+							const uint length = state.Read16();
+							dma.lengthCounter = NST_MAX(NST_MIN(length,0xFF1U),1U);
+						}
+
+						break;
 				}
 
 				state.End();
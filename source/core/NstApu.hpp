@@ -34,6 +34,7 @@ namespace Nes
 		{
 			class Output;
 			class Buffer;
+			class StepBuffer;
 		}
 
 		namespace State
@@ -85,6 +86,8 @@ namespace Nes
 			void   SetMode(Mode);
 			void   BeginFrame(Sound::Output*);
 			void   EndFrame();
+			bool   IsSynthRunning() const;
+			void   ResumeSynth();
 			void   Poke_4017(uint);
 			uint   GetLatency() const;
 			Result SetSampleRate(dword);
@@ -94,6 +97,10 @@ namespace Nes
 			uint   GetVolume(uint) const;
 			void   SetAutoTranspose(bool);
 			void   EnableStereo(bool);
+			Result SetBandLimiting(bool);
+			void   SetStemOutput(bool);
+			void   SetRateControl(bool);
+			Result SetRateAdjustment(idword);
 
 			inline void Update();
 
@@ -106,11 +113,14 @@ namespace Nes
 				enum
 				{
 					MAX_CHANNELS = Apu::MAX_CHANNELS,
-					DEFAULT_VOLUME = Apu::DEFAULT_VOLUME
+					DEFAULT_VOLUME = Apu::DEFAULT_VOLUME,
+					BLOCK_SIZE = 128
 				};
 
 				virtual void Reset() = 0;
 				virtual Sample GetSample() = 0;
+				virtual Sample GetStems(Sample (&)[MAX_CHANNELS]);
+				virtual Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				void SetContext(Cycle,Cycle,Mode,const u8 (&)[MAX_CHANNELS]);
 
@@ -346,18 +356,33 @@ namespace Nes
 			NES_DECL_PEEK( 4015 )
 			NES_DECL_PEEK( 4xxx )
 
+			inline Sample Mix(Sample);
 			Sample GetSample();
+			NST_NO_INLINE Sample GetStemSample();
 
-			void SyncOff (Cycle);
-			void SyncOn  (Cycle);
+			void SyncOff     (Cycle);
+			void SyncOn      (Cycle);
+			void SyncStepped (Cycle);
+
+			inline void StepSquares(Cycle);
+			inline void StepTnd(Cycle);
+			void Synthesize(Cycle);
+			void RenderSteps();
 
 			Cycle ClockOscillators();
 			void ClockDmc(Cycle);
+			inline void SyncIdleDmc();
 			NST_NO_INLINE void ClockFrameIRQ();
 
+			template<typename T>
+			void SyncBlocks(T&,Cycle,uint);
+
 			template<typename T>
 			void UpdateBuffer(T);
 
+			template<typename T>
+			void Flush(T);
+
 			void UpdateSettings();
 
 			struct Cycles
@@ -389,6 +414,8 @@ namespace Nes
 
 				void Reset();
 				void SetContext(Cycle,Cycle);
+				void SaveClock(State::Saver&,uint) const;
+				uint LoadClock(State::Loader&);
 
 				ibool active;
 				iword timer;
@@ -400,6 +427,7 @@ namespace Nes
 			public:
 
 				inline void ClearAmp();
+				inline void SetStepClock(Cycle,Cycle);
 			};
 
 			class Square : public Oscillator
@@ -417,6 +445,10 @@ namespace Nes
 				inline void Toggle(uint);
 				dword GetSample();
 
+				NST_FORCE_INLINE Cycle Step();
+				NST_FORCE_INLINE dword GetLevel() const;
+				inline Cycle GetStepClock(Cycle,Cycle);
+
 				void ClockEnvelope();
 				void ClockSweep(uint);
 
@@ -472,6 +504,8 @@ namespace Nes
 				uint sweepNegate;
 				uint waveLength;
 				ibool validFrequency;
+
+				static const u8 steps[4][8];
 			};
 
 			class Triangle : public Oscillator
@@ -487,6 +521,10 @@ namespace Nes
 				NST_FORCE_INLINE void Toggle(uint);
 				NST_FORCE_INLINE dword GetSample();
 
+				NST_FORCE_INLINE Cycle Step();
+				NST_FORCE_INLINE dword GetLevel() const;
+				inline Cycle GetStepClock(Cycle,Cycle) const;
+
 				void ClockLinearCounter();
 				void ClockLengthCounter();
 
@@ -531,6 +569,8 @@ namespace Nes
 				uint waveLength;
 				uint outputVolume;
 				LengthCounter lengthCounter;
+
+				static const u8 steps[32];
 			};
 
 			class Noise : public Oscillator
@@ -546,6 +586,10 @@ namespace Nes
 				NST_FORCE_INLINE void Toggle(uint);
 				NST_FORCE_INLINE dword GetSample();
 
+				NST_FORCE_INLINE Cycle Step();
+				NST_FORCE_INLINE dword GetLevel() const;
+				inline Cycle GetStepClock(Cycle,Cycle);
+
 				void ClockEnvelope();
 				void ClockLengthCounter();
 
@@ -598,6 +642,7 @@ namespace Nes
 
 				inline uint CheckSample() const;
 				inline void ClearAmp();
+				inline void Skip(Cycle);
 				inline uint SetSample(uint);
 				inline Cycle GetFrequency() const;
 				inline uint GetLengthCounter() const;
@@ -667,6 +712,13 @@ namespace Nes
 				uint outputVolume;
 
 				static const Cycle lut[2][16];
+
+			public:
+
+				bool IsIdle() const
+				{
+					return !(active | dma.buffered | dma.lengthCounter);
+				}
 			};
 
 			struct Context
@@ -679,9 +731,24 @@ namespace Nes
 				bool transpose;
 				bool stereo;
 				bool audible;
+				bool bandLimiting;
+				bool stems;
+				bool rateControl;
+				idword rateAdjustment;
 				u8 volumes[MAX_CHANNELS];
 			};
 
+			struct Stems
+			{
+				void Reset();
+
+				ibool enabled;
+				uint count;
+				DcBlocker dcBlockers[CHANNEL_DPCM+1];
+			};
+
+			struct Synth;
+
 			Sound::Output* stream;
 			uint ctrl;
 			Updater updater;
@@ -694,7 +761,9 @@ namespace Nes
 			Dmc dmc;
 			Channel* extChannel;
 			DcBlocker dcBlocker;
+			Stems stems;
 			Sound::Buffer& buffer;
+			Synth* synth;
 			Context context;
 
 		public:
@@ -724,6 +793,26 @@ namespace Nes
 				return context.stereo;
 			}
 
+			bool IsBandLimiting() const
+			{
+				return context.bandLimiting;
+			}
+
+			bool IsStemOutput() const
+			{
+				return context.stems;
+			}
+
+			bool IsRateControlled() const
+			{
+				return context.rateControl;
+			}
+
+			idword GetRateAdjustment() const
+			{
+				return context.rateAdjustment;
+			}
+
 			bool IsAudible() const
 			{
 				return context.audible;
@@ -748,7 +837,9 @@ namespace Nes
 				if (cycles.dmcClock <= elapsed)
 					ClockDmc( elapsed );
 
-				return NST_MIN(cycles.frameIrqClock,cycles.dmcClock);
+				// an idle DMC can wait until it's clocked for some other reason
+
+				return dmc.IsIdle() ? cycles.frameIrqClock : NST_MIN(cycles.frameIrqClock,cycles.dmcClock);
 			}
 		};
 	}
@@ -38,6 +38,14 @@ namespace Nes
 	{
 		namespace Clock
 		{
+			// Units clocked by M2 are run lazily. Besides Signal() they must
+			// provide NextSignal(), returning the number of clocks up to and
+			// including the next one where Signal() may return true or have
+			// any other side effect, or 0 if there is none in sight. The
+			// IRQ is then scheduled as a cpu event instead of being checked
+			// after every instruction. Any other change to the unit must be
+			// preceded by a call to Update().
+
 			template<typename Unit,uint Divider=1U>
 			class M2
 			{
@@ -63,6 +71,9 @@ namespace Nes
 
 				NES_DECL_HOOK( Signaled )
 
+				void Synchronize();
+				void Schedule(Cycle);
+
 				Cycle count;
 				Cpu& cpu;
 				ibool enabled;
@@ -83,7 +94,11 @@ namespace Nes
 
 				void Update()
 				{
-					NES_CALL_HOOK(M2,Signaled);
+					// registers may change right after this,
+					// reschedule when the instruction is done
+
+					Synchronize();
+					Schedule( cpu.GetMasterClockCycles() );
 				}
 
 				void ClearIRQ() const
@@ -118,13 +133,11 @@ namespace Nes
 				enabled = enable;
 				count = 0;
 				unit.Reset( hard );
-				cpu.AddHook( Hook(this,&M2::Hook_Signaled) );
+				Schedule( cpu.GetMasterClockCycles() );
 			}
 
 			template<typename Unit,uint Divider>
-			#define NES_M2_FUNC_T M2<Unit,Divider> // template comma vs. macro comma
-			NES_HOOK(NES_M2_FUNC_T,Signaled)
-			#undef NES_M2_FUNC_T
+			void M2<Unit,Divider>::Synchronize()
 			{
 				NST_COMPILE_ASSERT( Divider <= 8 );
 
@@ -137,12 +150,50 @@ namespace Nes
 				}
 			}
 
+			template<typename Unit,uint Divider>
+			void M2<Unit,Divider>::Schedule(const Cycle cycle)
+			{
+				cpu.ScheduleEvent( Hook(this,&M2::Hook_Signaled), cycle );
+			}
+
+			template<typename Unit,uint Divider>
+			#define NES_M2_FUNC_T M2<Unit,Divider> // template comma vs. macro comma
+			NES_HOOK(NES_M2_FUNC_T,Signaled)
+			#undef NES_M2_FUNC_T
+			{
+				Synchronize();
+
+				Cycle next = NES_CYCLE_MAX;
+
+				if (enabled)
+				{
+					// the event is due as soon as the cpu has passed the
+					// clock, same as when it was checked per instruction
+
+					const dword signals = unit.NextSignal();
+
+					if (signals && signals <= cpu.GetMasterClockFrameCycles() / cpu.GetMasterClockCycle( Divider ))
+						next = count + (signals - 1) * cpu.GetMasterClockCycle( Divider ) + 1;
+				}
+
+				Schedule( next );
+			}
+
 			template<typename Unit,uint Divider>
 			void M2<Unit,Divider>::VSync()
 			{
 				count = (count > cpu.GetMasterClockFrameCycles() ? count - cpu.GetMasterClockFrameCycles() : 0);
+
+				// units may get touched on frame boundaries
+
+				Schedule( cpu.GetMasterClockCycles() );
 			}
 
+			// Units clocked by A12 must provide NextSignal() on the same terms
+			// as the ones above. The PPU is caught up by a cpu event no later
+			// than when the earliest such signal could arrive, rising edges
+			// being at least one signal duration apart.
+
 			template<typename Unit>
 			class A12
 			{
@@ -170,6 +221,10 @@ namespace Nes
 			private:
 
 				NES_DECL_LINE( Signaled )
+				NES_DECL_HOOK( Sync )
+
+				void Rebase();
+				void Schedule(Cycle);
 
 				struct Base
 				{
@@ -208,9 +263,13 @@ namespace Nes
 					return ppu.IsA12Connected();
 				}
 
-				void Update() const
+				void Update()
 				{
+					// registers may change right after this,
+					// reschedule when the instruction is done
+
 					ppu.Update();
+					Schedule( cpu.GetMasterClockCycles() );
 				}
 
 				void ClearIRQ() const
@@ -230,24 +289,51 @@ namespace Nes
 			A12<Unit>::A12(Cpu& c,Ppu& p,uint b,IrqDelay d)
 			: count(0), delay(d), cpu(c), ppu(p), base(b)
 			{
-				VSync();
+				Rebase();
 			}
 
 			template<typename Unit> template<typename Param>
 			A12<Unit>::A12(Cpu& c,Ppu& p,uint b,IrqDelay d,Param& a)
 			: count(0), delay(d), cpu(c), ppu(p), unit(a), base(b)
 			{
-				VSync();
+				Rebase();
 			}
 
 			template<typename Unit>
 			void A12<Unit>::Reset(const bool hard,const bool enable)
 			{
 				count = 0;
-				VSync();
+				Rebase();
 				unit.Reset( hard );
 				EnableLine( enable );
-				ppu.EnableCpuSynchronization();
+				Schedule( cpu.GetMasterClockCycles() );
+			}
+
+			template<typename Unit>
+			void A12<Unit>::Schedule(const Cycle cycle)
+			{
+				cpu.ScheduleEvent( Hook(this,&A12::Hook_Sync), cycle );
+			}
+
+			template<typename Unit>
+			NES_HOOK(A12<Unit>,Sync)
+			{
+				ppu.Update();
+
+				Cycle next = NES_CYCLE_MAX;
+
+				if (IsLineEnabled())
+				{
+					// a rising edge can't be let through before the filter
+					// has expired, nor before the point the ppu is now at
+
+					const dword signals = unit.NextSignal();
+
+					if (signals && (!duration || signals <= cpu.GetMasterClockFrameCycles() / duration))
+						next = (count > cpu.GetMasterClockCycles() ? count : cpu.GetMasterClockCycles()) + (signals - 1) * duration + 1;
+				}
+
+				Schedule( next );
 			}
 
 			template<typename Unit>
@@ -262,6 +348,16 @@ namespace Nes
 
 			template<typename Unit>
 			void A12<Unit>::VSync()
+			{
+				Rebase();
+
+				// units may get touched on frame boundaries
+
+				Schedule( cpu.GetMasterClockCycles() );
+			}
+
+			template<typename Unit>
+			void A12<Unit>::Rebase()
 			{
 				count = (count > cpu.GetMasterClockFrameCycles() ? count - cpu.GetMasterClockFrameCycles() : 0);
 				duration = base.clock[cpu.GetMode()];
@@ -33,7 +33,7 @@ namespace Nes
 {
 	namespace Core
 	{
-		dword Cpu::logged = 0;
+		#ifndef NST_CPU_SWITCH_DISPATCH
 
 		void (Cpu::*const Cpu::opcodes[NUM_OPCODES])() =
 		{
@@ -103,6 +103,8 @@ namespace Nes
 			&Cpu::op0xFC, &Cpu::op0xFD, &Cpu::op0xFE, &Cpu::op0xFF
 		};
 
+		#endif
+
 		inline uint Cpu::IoMap::Peek8(const uint address) const
 		{
 			NST_ASSERT( address < (SIZE_64K + OVERFLOW_SIZE) );
@@ -166,7 +168,8 @@ namespace Nes
 		frameClock ( 0 ),
 		mode       ( MODE_NTSC ),
 		apu        ( this ),
-		map        ( this, &Cpu::Peek_Overflow, &Cpu::Poke_Overflow )
+		map        ( this, &Cpu::Peek_Overflow, &Cpu::Poke_Overflow ),
+		logged     ( 0 )
 		{
 			Boot();
 		}
@@ -191,7 +194,40 @@ namespace Nes
 			map( 0xFFFCU          ).Set( this, &Cpu::Peek_Jam_1,    &Cpu::Poke_Nop      );
 			map( 0xFFFDU          ).Set( this, &Cpu::Peek_Jam_2,    &Cpu::Poke_Nop      );
 
+			direct.Clear();
+			direct.ram = ram.mem;
+			MapDirect( 0x0000U, &direct.ram, RAM_SIZE-1 );
+
 			hooks.Clear();
+			events.Clear();
+
+			idle.vblankPoll = false;
+		}
+
+		void Cpu::MapDirect(const Address address,u8* const* const pages,const uint mask)
+		{
+			NST_ASSERT( address < SIZE_64K && !(address & Direct::PAGE_MASK) && pages && mask <= Direct::PAGE_MASK );
+
+			const uint page = address >> Direct::PAGE_SHIFT;
+
+			direct.pages[page] = pages;
+			direct.masks[page] = mask;
+			direct.ports[page] = map[address];
+			direct.Invalidate( address, address );
+		}
+
+		void Cpu::Direct::Clear()
+		{
+			for (uint i=0; i < NUM_PAGES; ++i)
+			{
+				read[i] = NULL;
+				pages[i] = NULL;
+				masks[i] = PAGE_MASK;
+			}
+
+			read[NUM_PAGES] = NULL;
+			ram = NULL;
+			dirty = false;
 		}
 
 		const Io::Port* Cpu::Linker::Add(const Address address,const uint level,const Io::Port& port,IoMap& map)
@@ -258,6 +294,40 @@ namespace Nes
 			return entry->next;
 		}
 
+		void Cpu::Direct::Invalidate(const uint first,const uint last)
+		{
+			NST_ASSERT( first <= last );
+
+			for (uint i=first >> PAGE_SHIFT, n=NST_MIN(last >> PAGE_SHIFT,NUM_PAGES-1); i <= n; ++i)
+			{
+				read[i] = NULL;
+				dirty |= (pages[i] != NULL);
+			}
+		}
+
+		void Cpu::Direct::Validate(const IoMap& map)
+		{
+			// a page is only read from directly if every port in
+			// it still reads through the handler it was registered with
+
+			dirty = false;
+
+			for (uint i=0; i < NUM_PAGES; ++i)
+			{
+				if (pages[i] && !read[i])
+				{
+					uint address = i << PAGE_SHIFT;
+					const uint end = address + SIZE_8K;
+
+					while (address != end && map[address].SameReader( ports[i] ))
+						++address;
+
+					if (address == end)
+						read[i] = pages[i];
+				}
+			}
+		}
+
 		void Cpu::Linker::Remove(const Address address,const Io::Port& port,IoMap& map)
 		{
 			for (Chain *it=chain, *prev=NULL; it; prev=it, it=it->next)
@@ -326,6 +396,23 @@ namespace Nes
 			}
 		}
 
+		void Cpu::ScheduleEvent(const Hook& hook,const Cycle cycle)
+		{
+			events.Schedule( hook, cycle );
+			cycles.NextRound( cycle );
+		}
+
+		void Cpu::MapVBlankPoll(const Address address)
+		{
+			// the port at this address must be side-effect free to poll and
+			// can only raise bit 7 at the very end of the frame
+
+			NST_ASSERT( address < SIZE_64K );
+
+			idle.vblank = map[address];
+			idle.vblankPoll = true;
+		}
+
 		void Cpu::Cycles::Update(const Mode mode)
 		{
 			const uint divider = (mode == MODE_NTSC ? MC_DIV_NTSC : MC_DIV_PAL);
@@ -349,6 +436,87 @@ namespace Nes
 			low = 0;
 		}
 
+		Cpu::Events::Events()
+		: clock(NES_CYCLE_MAX) {}
+
+		void Cpu::Events::Clear()
+		{
+			list.Clear();
+			clock = NES_CYCLE_MAX;
+		}
+
+		void Cpu::Events::Expire()
+		{
+			for (uint i=0; i < list.Size(); ++i)
+				list[i].clock = 0;
+
+			clock = (list.Size() ? 0 : NES_CYCLE_MAX);
+		}
+
+		void Cpu::Events::Schedule(const Hook& hook,const Cycle cycle)
+		{
+			for (uint i=0; ; ++i)
+			{
+				if (i == list.Size())
+				{
+					list << Event( hook, cycle );
+					break;
+				}
+				else if (list[i].hook == hook)
+				{
+					list[i].clock = cycle;
+					break;
+				}
+			}
+
+			if (clock > cycle)
+				clock = cycle;
+		}
+
+		void Cpu::Events::Clock()
+		{
+			for (uint i=0; i < list.Size(); ++i)
+			{
+				// the handler is expected to reschedule itself
+
+				list[i].clock = NES_CYCLE_MAX;
+				const Hook hook( list[i].hook );
+				hook.Execute();
+			}
+
+			clock = NES_CYCLE_MAX;
+
+			for (uint i=0; i < list.Size(); ++i)
+			{
+				if (clock > list[i].clock)
+					clock = list[i].clock;
+			}
+		}
+
+		void Cpu::Events::EndFrame(const Cycle frameClock)
+		{
+			for (uint i=0; i < list.Size(); ++i)
+			{
+				if (list[i].clock != NES_CYCLE_MAX)
+					list[i].clock = (list[i].clock > frameClock ? list[i].clock - frameClock : 0);
+			}
+
+			if (clock != NES_CYCLE_MAX)
+				clock = (clock > frameClock ? clock - frameClock : 0);
+		}
+
+		Cpu::Idle::Idle()
+		: enabled(false), vblankPoll(false)
+		{
+			Reset();
+		}
+
+		void Cpu::Idle::Reset()
+		{
+			branch = NO_BRANCH;
+			skipped = 0;
+		}
+
 		void Cpu::Interrupt::Jam()
 		{
 			nmiClock = NES_CYCLE_MAX;
@@ -392,6 +560,8 @@ namespace Nes
 
 			cycles.Reset();
 			interrupt.Reset();
+			events.Expire();
+			idle.Reset();
 
 			flags.i  = Flags::I;
 			pc       = RESET_VECTOR;
@@ -442,6 +612,11 @@ namespace Nes
 
 				state.Begin('F','R','M','\0').Write( data ).End();
 			}
+
+			// exactly when the pending interrupts go off, older
+			// states have them fire on the first cycle instead
+
+			state.Begin('I','N','T','\0').Write32( interrupt.nmiClock ).Write32( interrupt.irqClock ).End();
 		}
 
 		void Cpu::LoadState(State::Loader& state)
@@ -499,7 +674,9 @@ namespace Nes
 						if (bool(mode == MODE_PAL) != bool(data[0] & SAVE_PAL))
 							cycles.Update( mode );
 
-						if (cycles.count >= frameClock)
+						// no frame has been run to tell its length before power-on
+
+						if (frameClock && cycles.count >= frameClock)
 							cycles.count = 0;
 
 						jammed = data[0] & SAVE_JAMMED;
@@ -509,13 +686,32 @@ namespace Nes
 
 						break;
 					}
+
+					case NES_STATE_CHUNK_ID('I','N','T','\0'):
+					{
+						const Cycle nmiClock = state.Read32();
+						const Cycle irqClock = state.Read32();
+
+						if (interrupt.nmiClock != NES_CYCLE_MAX)
+							interrupt.nmiClock = nmiClock;
+
+						if (interrupt.irqClock != NES_CYCLE_MAX)
+							interrupt.irqClock = irqClock;
+
+						break;
+					}
 				}
 
 				state.End();
 			}
+
+			// deadlines are derived from the device states loaded
+			// alongside, let everyone recalculate on the next clock
+
+			events.Expire();
 		}
 
-		void Cpu::TryLogMsg(cstring const msg,const uint length,const uint which)
+		void Cpu::TryLogMsg(cstring const msg,const uint length,const uint which) const
 		{
 			NST_DEBUG_MSG( msg );
 
@@ -527,7 +723,7 @@ namespace Nes
 		}
 
 		template<size_t N>
-		inline void Cpu::LogMsg(const char (&c)[N],const uint e)
+		inline void Cpu::LogMsg(const char (&c)[N],const uint e) const
 		{
 			TryLogMsg( c, N-1, e );
 		}
@@ -647,16 +843,47 @@ namespace Nes
 			return ram.page.zero[address & 0xFF] | (ram.page.zero[(address+1) & 0xFF] << 8);
 		}
 
+		inline uint Cpu::Peek8(const uint address) const
+		{
+			const uint page = address >> Direct::PAGE_SHIFT;
+
+			if (const u8* const* const data = direct.read[page])
+				return (*data)[address & direct.masks[page]];
+			else
+				return map.Peek8( address );
+		}
+
+		inline uint Cpu::PeekPc8() const
+		{
+			return Peek8( pc );
+		}
+
+		inline uint Cpu::PeekPc16() const
+		{
+			const uint page = pc >> Direct::PAGE_SHIFT;
+			const u8* const* const data = direct.read[page];
+
+			if (data && (pc & direct.masks[page]) != direct.masks[page])
+			{
+				const u8* const ptr = *data + (pc & direct.masks[page]);
+				return ptr[0] | uint(ptr[1]) << 8;
+			}
+			else
+			{
+				return map.Peek16( pc );
+			}
+		}
+
 		inline uint Cpu::FetchPc8()
 		{
-			const uint data = map.Peek8( pc );
+			const uint data = PeekPc8();
 			++pc;
 			return data;
 		}
 
 		inline uint Cpu::FetchPc16()
 		{
-			const uint data = map.Peek16( pc );
+			const uint data = PeekPc16();
 			pc += 2;
 			return data;
 		}
@@ -681,7 +908,7 @@ namespace Nes
 			uint data = FetchPc16();
 			cycles.count += cycles.clock[2];
 
-			data = map.Peek8( data );
+			data = Peek8( data );
 			cycles.count += cycles.clock[0];
 
 			return data;
@@ -692,7 +919,7 @@ namespace Nes
 			const uint address = FetchPc16();
 			cycles.count += cycles.clock[2];
 
-			data = map.Peek8( address );
+			data = Peek8( address );
 			cycles.count += cycles.clock[0];
 
 			map.Poke8( address, data );
@@ -778,17 +1005,17 @@ namespace Nes
 		uint Cpu::AbsReg_R(uint indexed)
 		{
 			uint data = pc;
-			indexed += map.Peek8( data );
-			data = (map.Peek8( data + 1 ) << 8) + indexed;
+			indexed += Peek8( data );
+			data = (Peek8( data + 1 ) << 8) + indexed;
 			cycles.count += cycles.clock[2];
 
 			if (indexed & 0x100)
 			{
-				map.Peek8( data - 0x100 );
+				Peek8( data - 0x100 );
 				cycles.count += cycles.clock[0];
 			}
 
-			data = map.Peek8( data );
+			data = Peek8( data );
 			pc += 2;
 			cycles.count += cycles.clock[0];
 
@@ -798,14 +1025,14 @@ namespace Nes
 		uint Cpu::AbsReg_RW(uint& data,uint indexed)
 		{
 			uint address = pc;
-			indexed += map.Peek8( address );
-			address = (map.Peek8( address + 1 ) << 8) + indexed;
+			indexed += Peek8( address );
+			address = (Peek8( address + 1 ) << 8) + indexed;
 
-			map.Peek8( address - (indexed & 0x100) );
+			Peek8( address - (indexed & 0x100) );
 			pc += 2;
 			cycles.count += cycles.clock[3];
 
-			data = map.Peek8( address );
+			data = Peek8( address );
 			cycles.count += cycles.clock[0];
 
 			map.Poke8( address, data );
@@ -817,10 +1044,10 @@ namespace Nes
 		NST_FORCE_INLINE uint Cpu::AbsReg_W(uint indexed)
 		{
 			uint address = pc;
-			indexed += map.Peek8( address );
-			address = (map.Peek8( address + 1 ) << 8) + indexed;
+			indexed += Peek8( address );
+			address = (Peek8( address + 1 ) << 8) + indexed;
 
-			map.Peek8( address - (indexed & 0x100) );
+			Peek8( address - (indexed & 0x100) );
 			pc += 2;
 			cycles.count += cycles.clock[3];
 
@@ -848,7 +1075,7 @@ namespace Nes
 			cycles.count += cycles.clock[4];
 			data = FetchZpg16( data );
 
-			data = map.Peek8( data );
+			data = Peek8( data );
 			cycles.count += cycles.clock[0];
 
 			return data;
@@ -860,7 +1087,7 @@ namespace Nes
 			cycles.count += cycles.clock[4];
 			address = FetchZpg16( address );
 
-			data = map.Peek8( address );
+			data = Peek8( address );
 			cycles.count += cycles.clock[0];
 
 			map.Poke8( address, data );
@@ -890,11 +1117,11 @@ namespace Nes
 
 			if (indexed & 0x100)
 			{
-				map.Peek8( data - 0x100 );
+				Peek8( data - 0x100 );
 				cycles.count += cycles.clock[0];
 			}
 
-			data = map.Peek8( data );
+			data = Peek8( data );
 			cycles.count += cycles.clock[0];
 
 			return data;
@@ -907,9 +1134,9 @@ namespace Nes
 
 			const uint indexed = ram.page.zero[address] + y;
 			address = (ram.page.zero[(address + 1) & 0xFF] << 8) + indexed;
-			map.Peek8( address - (indexed & 0x100) );
+			Peek8( address - (indexed & 0x100) );
 
-			data = map.Peek8( address );
+			data = Peek8( address );
 			cycles.count += cycles.clock[0];
 
 			map.Poke8( address, data );
@@ -926,7 +1153,7 @@ namespace Nes
 			const uint indexed = ram.page.zero[address] + y;
 			address = (ram.page.zero[(address + 1) & 0xFF] << 8) + indexed;
 
-			map.Peek8( address - (indexed & 0x100) );
+			Peek8( address - (indexed & 0x100) );
 
 			return address;
 		}
@@ -940,8 +1167,11 @@ namespace Nes
 		{
 			if ((!!tmp) == STATE)
 			{
-				pc = ((tmp=pc+1) + sign_cast<i8>(map.Peek8( pc ))) & 0xFFFFU;
+				pc = ((tmp=pc+1) + sign_cast<i8>(PeekPc8())) & 0xFFFFU;
 				cycles.count += cycles.clock[2 + ((tmp^pc) >> 8 & 1)];
+
+				if (idle.enabled && tmp - pc - 1U < Idle::MAX_LENGTH)
+					CheckIdleLoop( tmp - 2 );
 			}
 			else
 			{
@@ -1057,7 +1287,7 @@ namespace Nes
 
 		NST_FORCE_INLINE void Cpu::JmpAbs()
 		{
-			pc = map.Peek16( pc );
+			pc = PeekPc16();
 			cycles.count += cycles.clock[JMP_ABS_CYCLES-1];
 		}
 
@@ -1065,7 +1295,7 @@ namespace Nes
 		{
 			// 6502 trap, can't cross between pages
 
-			const uint pos = map.Peek16( pc );
+			const uint pos = PeekPc16();
 			pc = map.Peek8( pos ) | (map.Peek8( (pos & 0xFF00U) | ((pos + 1) & 0x00FFU) ) << 8);
 
 			cycles.count += cycles.clock[JMP_IND_CYCLES-1];
@@ -1077,7 +1307,7 @@ namespace Nes
 			// one byte prior to the next instruction
 
 			Push16( pc + 1 );
-			pc = map.Peek16( pc );
+			pc = PeekPc16();
 			cycles.count += cycles.clock[JSR_CYCLES-1];
 		}
 
@@ -1622,6 +1852,7 @@ namespace Nes
 			ticks += frameClock;
 			cycles.count -= frameClock;
 			interrupt.EndFrame( frameClock );
+			events.EndFrame( frameClock );
 		}
 
 		void Cpu::DoIRQ(const uint line,const Cycle cycle)
@@ -1648,8 +1879,173 @@ namespace Nes
 			}
 		}
 
+		uint Cpu::ScanIdleLoop(const uint target,const uint branch,const Cycle length)
+		{
+			// Accepts only straight-line loops made of instructions that neither
+			// write nor touch anything but RAM, or the plain vblank wait forms.
+			// Their state can then only change on the next round boundary.
+
+			const uint page = target >> Direct::PAGE_SHIFT;
+			const u8* const* const data = direct.read[page];
+
+			if (!data || (target ^ (branch + 1)) > direct.masks[page])
+				return Idle::POLL_NONE;
+
+			const u8* const op = *data + (target & direct.masks[page]);
+			const uint size = branch - target;
+
+			uint ticks = 3 + (((branch + 2) ^ target) >> 8 & 1);
+			uint poll = Idle::POLL_RAM;
+
+			if (size >= 3 && op[1] == 0x02 && op[2] == 0x20 && (op[0] == 0xAD || op[0] == 0x2C))
+			{
+				// bit/lda $2002 : bpl
+				// lda $2002 : and #$80 : bpl/beq
+
+				if (size == 3 && op[size] == 0x10)
+				{
+					ticks += 4;
+				}
+				else if (size == 5 && op[0] == 0xAD && op[3] == 0x29 && op[4] == 0x80 && (op[size] == 0x10 || op[size] == 0xF0))
+				{
+					ticks += 4 + 2;
+				}
+				else
+				{
+					return Idle::POLL_NONE;
+				}
+
+				if (!idle.vblankPoll || !map[0x2002].SameReader( idle.vblank ))
+					return Idle::POLL_NONE;
+
+				poll = Idle::POLL_VBLANK;
+			}
+			else
+			{
+				Io::Port ramPort;
+				ramPort.Set( &ram, &Cpu::Ram::Peek_Ram, &Cpu::Ram::Poke_Ram );
+
+				for (uint i=0; i < size; )
+				{
+					switch (op[i])
+					{
+						case 0xEA: case 0xAA: case 0xA8: case 0x8A:
+						case 0x98: case 0x18: case 0x38:
+
+							ticks += 2;
+							i += 1;
+							break;
+
+						case 0xA9: case 0xA2: case 0xA0: case 0xC9: case 0xE0:
+						case 0xC0: case 0x29: case 0x09: case 0x49:
+
+							ticks += 2;
+							i += 2;
+							break;
+
+						case 0xA5: case 0xA6: case 0xA4: case 0xC5: case 0xE4:
+						case 0xC4: case 0x24: case 0x25: case 0x05: case 0x45:
+
+							ticks += 3;
+							i += 2;
+							break;
+
+						case 0xAD: case 0xAE: case 0xAC: case 0xCD: case 0xEC:
+						case 0xCC: case 0x2C: case 0x2D: case 0x0D: case 0x4D:
+
+							if (i + 3 > size)
+								return Idle::POLL_NONE;
+
+							{
+								const uint address = op[i+1] | uint(op[i+2]) << 8;
+
+								if (address >= 0x2000 || !map[address].SameReader( ramPort ))
+									return Idle::POLL_NONE;
+							}
+
+							ticks += 4;
+							i += 3;
+							break;
+
+						default:
+
+							return Idle::POLL_NONE;
+					}
+
+					if (i > size)
+						return Idle::POLL_NONE;
+				}
+			}
+
+			// a different length means the branch was reached through other code
+
+			return length == ticks * cycles.clock[0] ? poll : uint(Idle::POLL_NONE);
+		}
+
+		void Cpu::CheckIdleLoop(const uint branch)
+		{
+			if
+			(
+				idle.branch == branch &&
+				idle.target == pc &&
+				idle.a == a &&
+				idle.x == x &&
+				idle.y == y &&
+				idle.sp == sp &&
+				idle.flags.nz == flags.nz &&
+				idle.flags.c == flags.c &&
+				idle.flags.v == flags.v &&
+				idle.flags.i == flags.i &&
+				idle.flags.d == flags.d &&
+				hooks.Size() == 0
+			)
+			{
+				const Cycle length = cycles.count - idle.count;
+
+				if (const uint poll = ScanIdleLoop( pc, branch, length ))
+				{
+					Cycle limit = cycles.round;
+
+					// the vblank flag can't go up before the frame ends
+
+					if (poll == Idle::POLL_VBLANK && limit > frameClock - cycles.clock[1])
+						limit = frameClock - cycles.clock[1];
+
+					if (limit > cycles.count + length)
+					{
+						// run the remaining iterations up to the limit in one go,
+						// the last ones are executed for real
+
+						const Cycle skip = (limit - cycles.count - 1) / length * length;
+
+						cycles.count += skip;
+						idle.skipped += skip / cycles.clock[0];
+					}
+				}
+			}
+
+			idle.branch = branch;
+			idle.target = pc;
+			idle.count = cycles.count;
+			idle.a = a;
+			idle.x = x;
+			idle.y = y;
+			idle.sp = sp;
+			idle.flags = flags;
+		}
+
 		void Cpu::Clock()
 		{
+			if (direct.dirty)
+				direct.Validate( map );
+
+			idle.branch = Idle::NO_BRANCH;
+
+			// event driven units are synchronized along with everything
+			// else, their deadlines merely make sure it happens in time
+
+			events.Clock();
+
 			Cycle clock = apu.Clock( cycles.count );
 
 			if (const uint vector = interrupt.Clock( cycles.count ))
@@ -1661,19 +2057,103 @@ namespace Nes
 			if (clock > interrupt.nmiClock)
 				clock = interrupt.nmiClock;
 
+			if (clock > events.clock)
+				clock = events.clock;
+
 			if (clock > frameClock)
 				clock = frameClock;
 
 			cycles.round = clock;
 		}
 
+		NST_FORCE_INLINE void Cpu::ExecuteOp(const uint opcode)
+		{
+          #ifdef NST_CPU_SWITCH_DISPATCH
+
+			switch (opcode)
+			{
+				case 0x00: op0x00(); break; case 0x01: op0x01(); break; case 0x02: op0x02(); break; case 0x03: op0x03(); break;
+				case 0x04: op0x04(); break; case 0x05: op0x05(); break; case 0x06: op0x06(); break; case 0x07: op0x07(); break;
+				case 0x08: op0x08(); break; case 0x09: op0x09(); break; case 0x0A: op0x0A(); break; case 0x0B: op0x0B(); break;
+				case 0x0C: op0x0C(); break; case 0x0D: op0x0D(); break; case 0x0E: op0x0E(); break; case 0x0F: op0x0F(); break;
+				case 0x10: op0x10(); break; case 0x11: op0x11(); break; case 0x12: op0x12(); break; case 0x13: op0x13(); break;
+				case 0x14: op0x14(); break; case 0x15: op0x15(); break; case 0x16: op0x16(); break; case 0x17: op0x17(); break;
+				case 0x18: op0x18(); break; case 0x19: op0x19(); break; case 0x1A: op0x1A(); break; case 0x1B: op0x1B(); break;
+				case 0x1C: op0x1C(); break; case 0x1D: op0x1D(); break; case 0x1E: op0x1E(); break; case 0x1F: op0x1F(); break;
+				case 0x20: op0x20(); break; case 0x21: op0x21(); break; case 0x22: op0x22(); break; case 0x23: op0x23(); break;
+				case 0x24: op0x24(); break; case 0x25: op0x25(); break; case 0x26: op0x26(); break; case 0x27: op0x27(); break;
+				case 0x28: op0x28(); break; case 0x29: op0x29(); break; case 0x2A: op0x2A(); break; case 0x2B: op0x2B(); break;
+				case 0x2C: op0x2C(); break; case 0x2D: op0x2D(); break; case 0x2E: op0x2E(); break; case 0x2F: op0x2F(); break;
+				case 0x30: op0x30(); break; case 0x31: op0x31(); break; case 0x32: op0x32(); break; case 0x33: op0x33(); break;
+				case 0x34: op0x34(); break; case 0x35: op0x35(); break; case 0x36: op0x36(); break; case 0x37: op0x37(); break;
+				case 0x38: op0x38(); break; case 0x39: op0x39(); break; case 0x3A: op0x3A(); break; case 0x3B: op0x3B(); break;
+				case 0x3C: op0x3C(); break; case 0x3D: op0x3D(); break; case 0x3E: op0x3E(); break; case 0x3F: op0x3F(); break;
+				case 0x40: op0x40(); break; case 0x41: op0x41(); break; case 0x42: op0x42(); break; case 0x43: op0x43(); break;
+				case 0x44: op0x44(); break; case 0x45: op0x45(); break; case 0x46: op0x46(); break; case 0x47: op0x47(); break;
+				case 0x48: op0x48(); break; case 0x49: op0x49(); break; case 0x4A: op0x4A(); break; case 0x4B: op0x4B(); break;
+				case 0x4C: op0x4C(); break; case 0x4D: op0x4D(); break; case 0x4E: op0x4E(); break; case 0x4F: op0x4F(); break;
+				case 0x50: op0x50(); break; case 0x51: op0x51(); break; case 0x52: op0x52(); break; case 0x53: op0x53(); break;
+				case 0x54: op0x54(); break; case 0x55: op0x55(); break; case 0x56: op0x56(); break; case 0x57: op0x57(); break;
+				case 0x58: op0x58(); break; case 0x59: op0x59(); break; case 0x5A: op0x5A(); break; case 0x5B: op0x5B(); break;
+				case 0x5C: op0x5C(); break; case 0x5D: op0x5D(); break; case 0x5E: op0x5E(); break; case 0x5F: op0x5F(); break;
+				case 0x60: op0x60(); break; case 0x61: op0x61(); break; case 0x62: op0x62(); break; case 0x63: op0x63(); break;
+				case 0x64: op0x64(); break; case 0x65: op0x65(); break; case 0x66: op0x66(); break; case 0x67: op0x67(); break;
+				case 0x68: op0x68(); break; case 0x69: op0x69(); break; case 0x6A: op0x6A(); break; case 0x6B: op0x6B(); break;
+				case 0x6C: op0x6C(); break; case 0x6D: op0x6D(); break; case 0x6E: op0x6E(); break; case 0x6F: op0x6F(); break;
+				case 0x70: op0x70(); break; case 0x71: op0x71(); break; case 0x72: op0x72(); break; case 0x73: op0x73(); break;
+				case 0x74: op0x74(); break; case 0x75: op0x75(); break; case 0x76: op0x76(); break; case 0x77: op0x77(); break;
+				case 0x78: op0x78(); break; case 0x79: op0x79(); break; case 0x7A: op0x7A(); break; case 0x7B: op0x7B(); break;
+				case 0x7C: op0x7C(); break; case 0x7D: op0x7D(); break; case 0x7E: op0x7E(); break; case 0x7F: op0x7F(); break;
+				case 0x80: op0x80(); break; case 0x81: op0x81(); break; case 0x82: op0x82(); break; case 0x83: op0x83(); break;
+				case 0x84: op0x84(); break; case 0x85: op0x85(); break; case 0x86: op0x86(); break; case 0x87: op0x87(); break;
+				case 0x88: op0x88(); break; case 0x89: op0x89(); break; case 0x8A: op0x8A(); break; case 0x8B: op0x8B(); break;
+				case 0x8C: op0x8C(); break; case 0x8D: op0x8D(); break; case 0x8E: op0x8E(); break; case 0x8F: op0x8F(); break;
+				case 0x90: op0x90(); break; case 0x91: op0x91(); break; case 0x92: op0x92(); break; case 0x93: op0x93(); break;
+				case 0x94: op0x94(); break; case 0x95: op0x95(); break; case 0x96: op0x96(); break; case 0x97: op0x97(); break;
+				case 0x98: op0x98(); break; case 0x99: op0x99(); break; case 0x9A: op0x9A(); break; case 0x9B: op0x9B(); break;
+				case 0x9C: op0x9C(); break; case 0x9D: op0x9D(); break; case 0x9E: op0x9E(); break; case 0x9F: op0x9F(); break;
+				case 0xA0: op0xA0(); break; case 0xA1: op0xA1(); break; case 0xA2: op0xA2(); break; case 0xA3: op0xA3(); break;
+				case 0xA4: op0xA4(); break; case 0xA5: op0xA5(); break; case 0xA6: op0xA6(); break; case 0xA7: op0xA7(); break;
+				case 0xA8: op0xA8(); break; case 0xA9: op0xA9(); break; case 0xAA: op0xAA(); break; case 0xAB: op0xAB(); break;
+				case 0xAC: op0xAC(); break; case 0xAD: op0xAD(); break; case 0xAE: op0xAE(); break; case 0xAF: op0xAF(); break;
+				case 0xB0: op0xB0(); break; case 0xB1: op0xB1(); break; case 0xB2: op0xB2(); break; case 0xB3: op0xB3(); break;
+				case 0xB4: op0xB4(); break; case 0xB5: op0xB5(); break; case 0xB6: op0xB6(); break; case 0xB7: op0xB7(); break;
+				case 0xB8: op0xB8(); break; case 0xB9: op0xB9(); break; case 0xBA: op0xBA(); break; case 0xBB: op0xBB(); break;
+				case 0xBC: op0xBC(); break; case 0xBD: op0xBD(); break; case 0xBE: op0xBE(); break; case 0xBF: op0xBF(); break;
+				case 0xC0: op0xC0(); break; case 0xC1: op0xC1(); break; case 0xC2: op0xC2(); break; case 0xC3: op0xC3(); break;
+				case 0xC4: op0xC4(); break; case 0xC5: op0xC5(); break; case 0xC6: op0xC6(); break; case 0xC7: op0xC7(); break;
+				case 0xC8: op0xC8(); break; case 0xC9: op0xC9(); break; case 0xCA: op0xCA(); break; case 0xCB: op0xCB(); break;
+				case 0xCC: op0xCC(); break; case 0xCD: op0xCD(); break; case 0xCE: op0xCE(); break; case 0xCF: op0xCF(); break;
+				case 0xD0: op0xD0(); break; case 0xD1: op0xD1(); break; case 0xD2: op0xD2(); break; case 0xD3: op0xD3(); break;
+				case 0xD4: op0xD4(); break; case 0xD5: op0xD5(); break; case 0xD6: op0xD6(); break; case 0xD7: op0xD7(); break;
+				case 0xD8: op0xD8(); break; case 0xD9: op0xD9(); break; case 0xDA: op0xDA(); break; case 0xDB: op0xDB(); break;
+				case 0xDC: op0xDC(); break; case 0xDD: op0xDD(); break; case 0xDE: op0xDE(); break; case 0xDF: op0xDF(); break;
+				case 0xE0: op0xE0(); break; case 0xE1: op0xE1(); break; case 0xE2: op0xE2(); break; case 0xE3: op0xE3(); break;
+				case 0xE4: op0xE4(); break; case 0xE5: op0xE5(); break; case 0xE6: op0xE6(); break; case 0xE7: op0xE7(); break;
+				case 0xE8: op0xE8(); break; case 0xE9: op0xE9(); break; case 0xEA: op0xEA(); break; case 0xEB: op0xEB(); break;
+				case 0xEC: op0xEC(); break; case 0xED: op0xED(); break; case 0xEE: op0xEE(); break; case 0xEF: op0xEF(); break;
+				case 0xF0: op0xF0(); break; case 0xF1: op0xF1(); break; case 0xF2: op0xF2(); break; case 0xF3: op0xF3(); break;
+				case 0xF4: op0xF4(); break; case 0xF5: op0xF5(); break; case 0xF6: op0xF6(); break; case 0xF7: op0xF7(); break;
+				case 0xF8: op0xF8(); break; case 0xF9: op0xF9(); break; case 0xFA: op0xFA(); break; case 0xFB: op0xFB(); break;
+				case 0xFC: op0xFC(); break; case 0xFD: op0xFD(); break; case 0xFE: op0xFE(); break; case 0xFF: op0xFF(); break;
+
+				NST_UNREACHABLE
+			}
+
+          #else
+
+			(*this.*(opcodes[opcode]))();
+
+          #endif
+		}
+
 		void Cpu::Run0()
 		{
 			do
 			{
 				do
 				{
-					(*this.*(opcodes[FetchPc8()]))();
+					ExecuteOp( FetchPc8() );
 				}
 				while (cycles.count < cycles.round);
 
@@ -1690,7 +2170,7 @@ namespace Nes
 			{
 				do
 				{
-					(*this.*(opcodes[FetchPc8()]))();
+					ExecuteOp( FetchPc8() );
 					hook.Execute();
 				}
 				while (cycles.count < cycles.round);
@@ -1709,7 +2189,7 @@ namespace Nes
 			{
 				do
 				{
-					(*this.*(opcodes[FetchPc8()]))();
+					ExecuteOp( FetchPc8() );
 
 					const Hook* NST_RESTRICT hook = begin;
 
@@ -32,13 +32,12 @@
 #include "NstIoMap.hpp"
 #include "NstApu.hpp"
 #include "NstVector.hpp"
+#include "NstHook.hpp"
 
 namespace Nes
 {
 	namespace Core
 	{
-		class Hook;
-
 		class Cpu
 		{
 		public:
@@ -110,6 +109,8 @@ namespace Nes
 			void SetMode(Mode);
 			void AddHook(const Hook&);
 			void RemoveHook(const Hook&);
+			void ScheduleEvent(const Hook&,Cycle);
+			void MapVBlankPoll(Address);
 
 			void SaveState (State::Saver&) const;
 			void LoadState (State::Loader&);
@@ -145,10 +146,10 @@ namespace Nes
 				SAVE_PAL       = b10000000
 			};
 
-			static void TryLogMsg(cstring,uint,uint);
+			void TryLogMsg(cstring,uint,uint) const;
 
 			template<size_t N>
-			static inline void LogMsg(const char (&)[N],uint);
+			inline void LogMsg(const char (&)[N],uint) const;
 
 			NES_DECL_POKE( Nop      )
 			NES_DECL_PEEK( Nop      )
@@ -164,6 +165,14 @@ namespace Nes
 			void Run1();
 			void Run2();
 
+			NST_FORCE_INLINE void ExecuteOp(uint);
+
+			NST_NO_INLINE void CheckIdleLoop(uint);
+			uint ScanIdleLoop(uint,uint,Cycle);
+
+			inline uint Peek8(uint) const;
+			inline uint PeekPc8() const;
+			inline uint PeekPc16() const;
 			inline uint FetchPc8();
 			inline uint FetchPc16();
 			inline uint FetchZpg16(uint) const;
@@ -410,6 +419,27 @@ namespace Nes
 				Chain* chain;
 			};
 
+			struct Direct
+			{
+				void Clear();
+				void Invalidate(uint,uint);
+				void Validate(const IoMap&);
+
+				enum
+				{
+					PAGE_SHIFT = 13,
+					PAGE_MASK = SIZE_8K - 1,
+					NUM_PAGES = SIZE_64K / SIZE_8K
+				};
+
+				u8* const* read[NUM_PAGES+1];
+				u8* const* pages[NUM_PAGES];
+				uint masks[NUM_PAGES];
+				Io::Port ports[NUM_PAGES];
+				u8* ram;
+				ibool dirty;
+			};
+
 			struct Ram
 			{
 				void Clear();
@@ -483,6 +513,65 @@ namespace Nes
 				uint low;
 			};
 
+			class Events
+			{
+				struct Event
+				{
+					Event(const Hook& h,Cycle c)
+					: hook(h), clock(c) {}
+
+					Hook hook;
+					Cycle clock;
+				};
+
+				Vector<Event> list;
+
+			public:
+
+				Events();
+
+				void Clear();
+				void Expire();
+				void Schedule(const Hook&,Cycle);
+				void Clock();
+				void EndFrame(Cycle);
+
+				Cycle clock;
+			};
+
+			struct Idle
+			{
+				Idle();
+
+				void Reset();
+
+				enum
+				{
+					MAX_LENGTH = 12,
+					NO_BRANCH = ~0U
+				};
+
+				enum Poll
+				{
+					POLL_NONE,
+					POLL_RAM,
+					POLL_VBLANK
+				};
+
+				uint branch;
+				uint target;
+				Cycle count;
+				uint a;
+				uint x;
+				uint y;
+				uint sp;
+				Flags flags;
+				ibool enabled;
+				ibool vblankPoll;
+				Io::Port vblank;
+				qword skipped;
+			};
+
 			uint pc;
 			Cycles cycles;
 			uint a;
@@ -491,18 +580,23 @@ namespace Nes
 			uint sp;
 			Flags flags;
 			Interrupt interrupt;
+			Events events;
+			Idle idle;
 			Cycle frameClock;
 			Ram ram;
 			Hooks hooks;
 			ibool jammed;
 			Mode mode;
 			Linker linker;
+			Direct direct;
 			qword ticks;
 			Apu apu;
 			IoMap map;
 
+			#ifndef NST_CPU_SWITCH_DISPATCH
 			static void (Cpu::*const opcodes[NUM_OPCODES])();
-			static dword logged;
+			#endif
+			mutable dword logged;
 
 		public:
 
@@ -578,6 +672,11 @@ namespace Nes
 				cycles.round = NST_MIN(cycles.round,count);
 			}
 
+			void NextRound(Cycle count)
+			{
+				cycles.round = NST_MIN(cycles.round,count);
+			}
+
 			void StealCycles(Cycle count)
 			{
 				cycles.count += count;
@@ -614,6 +713,22 @@ namespace Nes
 				return cycles.count * (MC_DIV_NTSC*1000UL) / (mode == MODE_NTSC ? MC_NTSC : MC_PAL);
 			}
 
+			void EnableIdleLoopSkipping(bool enable)
+			{
+				idle.enabled = enable;
+				idle.branch = Idle::NO_BRANCH;
+			}
+
+			bool IsIdleLoopSkippingEnabled() const
+			{
+				return idle.enabled;
+			}
+
+			qword GetIdleLoopSkippedCycles() const
+			{
+				return idle.skipped;
+			}
+
 			SystemRam GetSystemRam() const
 			{
 				return ram.mem;
@@ -634,23 +749,29 @@ namespace Nes
 
 			IoMap::Port Map(Address address)
 			{
+				direct.Invalidate( address, address );
 				return map( address );
 			}
 
 			IoMap::Ports Map(Address first,Address last)
 			{
+				direct.Invalidate( first, last );
 				return map( first, last );
 			}
 
+			void MapDirect(Address,u8* const*,uint=Direct::PAGE_MASK);
+
 			template<typename T,typename U,typename V>
 			const Io::Port* Link(Address address,uint level,T t,U u,V v)
 			{
+				direct.Invalidate( address, address );
 				return linker.Add( address, level, Io::Port(t,u,v), map );
 			}
 
 			template<typename T,typename U,typename V>
 			void Unlink(Address address,T t,U u,V v)
 			{
+				direct.Invalidate( address, address );
 				linker.Remove( address, Io::Port(t,u,v), map );
 			}
 
@@ -1678,6 +1678,26 @@ namespace Nes
 			return dcBlocker.Apply( amp * outputVolume / DEFAULT_VOLUME );
 		}
 
+		Fds::Sound::Sample Fds::Sound::GetStems(Sample (&stems)[MAX_CHANNELS])
+		{
+			return stems[Apu::CHANNEL_FDS] = GetSample();
+		}
+
+		Cycle Fds::Sound::Render(Sample* const output,const uint length,Cycle clock,const Cycle period,Cycle next)
+		{
+			for (uint i=0; i < length; ++i)
+			{
+				output[i] = Sound::GetSample();
+
+				while (next <= clock)
+					next += Sound::Clock();
+
+				clock += period;
+			}
+
+			return next;
+		}
+
 		ibool Fds::Unit::Drive::Advance(uint& timer)
 		{
 			NST_ASSERT( io && !count );
@@ -1895,6 +1915,12 @@ namespace Nes
 			);
 		}
 
+		dword Fds::Unit::NextSignal() const
+		{
+			const dword next = (timer.ctrl & Timer::CTRL_ENABLED) ? timer.count : 0;
+			return (drive.count && (!next || drive.count < next)) ? drive.count : next;
+		}
+
 		void Fds::VSync()
 		{
 			adapter.VSync();
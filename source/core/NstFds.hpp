@@ -104,6 +104,8 @@ namespace Nes
 				void Reset();
 				void UpdateContext(uint,const u8 (&w)[MAX_CHANNELS]);
 				Sample GetSample();
+				Sample GetStems(Sample (&)[MAX_CHANNELS]);
+				Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 				Cycle Clock();
 
 			private:
@@ -337,6 +339,7 @@ namespace Nes
 
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				enum
 				{
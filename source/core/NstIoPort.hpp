@@ -112,6 +112,11 @@ namespace Nes
 					return static_cast<const void*>(component) == ptr;
 				}
 
+				bool SameReader(const Port& p) const
+				{
+					return component == p.component && reader == p.reader;
+				}
+
 				bool operator == (const Port& p) const
 				{
 					return component == p.component && reader == p.reader && writer == p.writer;
@@ -188,6 +193,11 @@ namespace Nes
 					return component == ptr;
 				}
 
+				bool SameReader(const Port& p) const
+				{
+					return component == p.component && reader == p.reader;
+				}
+
 				bool operator == (const Port& p) const
 				{
 					return component == p.component && reader == p.reader && writer == p.writer;
@@ -47,6 +47,7 @@ namespace Nes
 		:
 		state         (Api::Machine::NTSC),
 		frame         (0),
+		renderInterval(1),
 		extPort       (new Input::AdapterTwo( new Input::Pad(cpu,0), new Input::Pad(cpu,1) )),
 		expPort       (new Input::Device( cpu )),
 		image         (NULL),
@@ -239,43 +240,92 @@ namespace Nes
 			}
 		}
 
-		Result Machine::SaveState(StdStream stream,bool compress,bool internal)
+		bool Machine::LightGunIsConnected() const
+		{
+			for (uint i=0, n=extPort->NumPorts(); i < n; ++i)
+			{
+				if (extPort->GetDevice( i )->GetType() == Api::Input::ZAPPER)
+					return true;
+			}
+
+			return false;
+		}
+
+		void Machine::SaveState(State::Saver& saver)
+		{
+			saver.Begin('N','S','T',0x1A);
+			{
+				saver.Begin('N','F','O','\0').Write32( image->GetPrgCrc() ).Write32( frame ).End();
+
+				cpu.SaveState( State::Saver::Subset(saver,'C','P','U','\0').Ref() );
+				ppu.SaveState( State::Saver::Subset(saver,'P','P','U','\0').Ref() );
+				cpu.GetApu().SaveState( State::Saver::Subset(saver,'A','P','U','\0').Ref() );
+				image->SaveState( State::Saver::Subset(saver,'I','M','G','\0').Ref() );
+
+				saver.Begin('P','R','T','\0');
+				{
+					if (extPort->NumPorts() == 4)
+					{
+						static_cast<const Input::AdapterFour*>(extPort)->SaveState
+						(
+							saver, NES_STATE_CHUNK_ID('4','S','C','\0')
+						);
+					}
+
+					for (uint i=0; i < extPort->NumPorts(); ++i)
+						extPort->GetDevice( i )->SaveState( saver, '0' + i );
+
+					expPort->SaveState( saver, 'X' );
+				}
+				saver.End();
+			}
+			saver.End();
+		}
+
+		Result Machine::SaveState(StdStream stream,uint compress,bool internal)
 		{
 			if ((state & (Api::Machine::GAME|Api::Machine::ON)) > Api::Machine::ON)
 			{
 				try
 				{
 					State::Saver saver( stream, compress, internal );
+					SaveState( saver );
 
-					saver.Begin('N','S','T',0x1A);
-					{
-						saver.Begin('N','F','O','\0').Write32( image->GetPrgCrc() ).Write32( frame ).End();
+					return RESULT_OK;
+				}
+				catch (Result result)
+				{
+					return result;
+				}
+				catch (const std::bad_alloc&)
+				{
+					return RESULT_ERR_OUT_OF_MEMORY;
+				}
+				catch (...)
+				{
+					return RESULT_ERR_GENERIC;
+				}
+			}
 
-						cpu.SaveState( State::Saver::Subset(saver,'C','P','U','\0').Ref() );
-						ppu.SaveState( State::Saver::Subset(saver,'P','P','U','\0').Ref() );
-						cpu.GetApu().SaveState( State::Saver::Subset(saver,'A','P','U','\0').Ref() );
-						image->SaveState( State::Saver::Subset(saver,'I','M','G','\0').Ref() );
+			return RESULT_ERR_NOT_READY;
+		}
 
-						saver.Begin('P','R','T','\0');
-						{
-							if (extPort->NumPorts() == 4)
-							{
-								static_cast<const Input::AdapterFour*>(extPort)->SaveState
-								(
-									saver, NES_STATE_CHUNK_ID('4','S','C','\0')
-								);
-							}
+		Result Machine::SaveState(void* data,dword& length,uint compress,bool internal)
+		{
+			// a NULL buffer just asks for the length, a short
+			// one gets it too but nothing usable written to it
 
-							for (uint i=0; i < extPort->NumPorts(); ++i)
-								extPort->GetDevice( i )->SaveState( saver, '0' + i );
+			if ((state & (Api::Machine::GAME|Api::Machine::ON)) > Api::Machine::ON)
+			{
+				try
+				{
+					State::Saver saver( data, length, compress, internal );
+					SaveState( saver );
 
-							expPort->SaveState( saver, 'X' );
-						}
-						saver.End();
-					}
-					saver.End();
+					const bool fits = (saver.Length() <= length);
+					length = saver.Length();
 
-					return RESULT_OK;
+					return (!data || fits) ? RESULT_OK : RESULT_ERR_OUT_OF_MEMORY;
 				}
 				catch (Result result)
 				{
@@ -294,122 +344,215 @@ namespace Nes
 			return RESULT_ERR_NOT_READY;
 		}
 
-		Result Machine::LoadState(StdStream stream,bool checkCrc)
+		Result Machine::SaveState(void* data,dword& length,const void* base,dword baseLength,bool internal)
 		{
-			if ((state & (Api::Machine::GAME|Api::Machine::ON)) <= Api::Machine::ON)
-				return RESULT_ERR_NOT_READY;
+			// only the pages that changed since the base state,
+			// see State::Saver::Materialize() for the way back
 
-			try
+			if ((state & (Api::Machine::GAME|Api::Machine::ON)) > Api::Machine::ON)
 			{
-				State::Loader loader( stream );
+				try
+				{
+					State::Saver saver( data, length, base, baseLength, internal );
+					SaveState( saver );
 
-				if (loader.Begin() != NES_STATE_CHUNK_ID('N','S','T',0x1A))
-					return RESULT_ERR_INVALID_FILE;
+					const dword size = saver.Diff();
+					const bool fits = (size <= length);
+					length = size;
 
-				loader.DigIn();
+					return (!data || fits) ? RESULT_OK : RESULT_ERR_OUT_OF_MEMORY;
+				}
+				catch (Result result)
+				{
+					return result;
+				}
+				catch (const std::bad_alloc&)
+				{
+					return RESULT_ERR_OUT_OF_MEMORY;
+				}
+				catch (...)
+				{
+					return RESULT_ERR_GENERIC;
+				}
+			}
 
-				while (const dword id = loader.Begin())
+			return RESULT_ERR_NOT_READY;
+		}
+
+		Result Machine::SaveState(State::Capture& capture,bool internal)
+		{
+			// taken as is, State::Capture::Save() does the rest
+
+			if ((state & (Api::Machine::GAME|Api::Machine::ON)) > Api::Machine::ON)
+			{
+				try
 				{
-					switch (id)
+					State::Saver saver( capture, internal );
+					SaveState( saver );
+
+					return RESULT_OK;
+				}
+				catch (Result result)
+				{
+					return result;
+				}
+				catch (const std::bad_alloc&)
+				{
+					return RESULT_ERR_OUT_OF_MEMORY;
+				}
+				catch (...)
+				{
+					return RESULT_ERR_GENERIC;
+				}
+			}
+
+			return RESULT_ERR_NOT_READY;
+		}
+
+		Result Machine::LoadState(State::Loader& loader,const bool checkCrc)
+		{
+			if (loader.Begin() != NES_STATE_CHUNK_ID('N','S','T',0x1A))
+				return RESULT_ERR_INVALID_FILE;
+
+			loader.DigIn();
+
+			while (const dword id = loader.Begin())
+			{
+				switch (id)
+				{
+					case NES_STATE_CHUNK_ID('N','F','O','\0'):
 					{
-						case NES_STATE_CHUNK_ID('N','F','O','\0'):
+						const dword crc = loader.Read32();
+
+						if
+						(
+							checkCrc && !(state & Api::Machine::DISK) &&
+							crc && crc != image->GetPrgCrc() &&
+							Api::User::questionCallback( Api::User::QUESTION_NST_PRG_CRC_FAIL_CONTINUE ) == Api::User::ANSWER_NO
+						)
 						{
-							const dword crc = loader.Read32();
-
-							if
-							(
-								checkCrc && !(state & Api::Machine::DISK) &&
-								crc && crc != image->GetPrgCrc() &&
-								Api::User::questionCallback( Api::User::QUESTION_NST_PRG_CRC_FAIL_CONTINUE ) == Api::User::ANSWER_NO
-							)
-							{
-								loader.End();
-								loader.DigOut();
-								return RESULT_ERR_INVALID_CRC;
-							}
-
-							frame = loader.Read32();
-							break;
+							loader.End();
+							loader.DigOut();
+							return RESULT_ERR_INVALID_CRC;
 						}
 
-						case NES_STATE_CHUNK_ID('C','P','U','\0'):
+						frame = loader.Read32();
+						break;
+					}
+
+					case NES_STATE_CHUNK_ID('C','P','U','\0'):
 
-							cpu.LoadState( State::Loader::Subset(loader).Ref() );
-							break;
+						cpu.LoadState( State::Loader::Subset(loader).Ref() );
+						break;
 
-						case NES_STATE_CHUNK_ID('P','P','U','\0'):
+					case NES_STATE_CHUNK_ID('P','P','U','\0'):
 
-							ppu.LoadState( State::Loader::Subset(loader).Ref() );
-							break;
+						ppu.LoadState( State::Loader::Subset(loader).Ref() );
+						break;
 
-						case NES_STATE_CHUNK_ID('A','P','U','\0'):
+					case NES_STATE_CHUNK_ID('A','P','U','\0'):
 
-							cpu.GetApu().LoadState( State::Loader::Subset(loader).Ref() );
-							break;
+						cpu.GetApu().LoadState( State::Loader::Subset(loader).Ref() );
+						break;
 
-						case NES_STATE_CHUNK_ID('I','M','G','\0'):
+					case NES_STATE_CHUNK_ID('I','M','G','\0'):
 
-							image->LoadState( State::Loader::Subset(loader).Ref() );
-							break;
+						image->LoadState( State::Loader::Subset(loader).Ref() );
+						break;
 
-						case NES_STATE_CHUNK_ID('P','R','T','\0'):
+					case NES_STATE_CHUNK_ID('P','R','T','\0'):
 
-							extPort->Reset();
-							expPort->Reset();
+						extPort->Reset();
+						expPort->Reset();
 
-							loader.DigIn();
+						loader.DigIn();
 
-							while (const dword subId = loader.Begin())
+						while (const dword subId = loader.Begin())
+						{
+							if (subId == NES_STATE_CHUNK_ID('4','S','C','\0'))
 							{
-								if (subId == NES_STATE_CHUNK_ID('4','S','C','\0'))
+								if (extPort->NumPorts() == 4)
 								{
-									if (extPort->NumPorts() == 4)
-									{
-										static_cast<Input::AdapterFour*>(extPort)->LoadState
-										(
-											State::Loader::Subset(loader).Ref()
-										);
-									}
+									static_cast<Input::AdapterFour*>(extPort)->LoadState
+									(
+										State::Loader::Subset(loader).Ref()
+									);
 								}
-								else switch (const uint index = (subId >> 16 & 0xFF))
-								{
-									case '2':
-									case '3':
-
-										if (extPort->NumPorts() != 4)
-											break;
-
-									case '0':
-									case '1':
+							}
+							else switch (const uint index = (subId >> 16 & 0xFF))
+							{
+								case '2':
+								case '3':
 
-										extPort->GetDevice( index - '0' )->LoadState
-										(
-											State::Loader::Subset(loader).Ref(), subId & 0xFF00FFFFUL
-										);
+									if (extPort->NumPorts() != 4)
 										break;
 
-									case 'X':
+								case '0':
+								case '1':
 
-										expPort->LoadState
-										(
-											State::Loader::Subset(loader).Ref(), subId & 0xFF00FFFFUL
-										);
-										break;
-								}
+									extPort->GetDevice( index - '0' )->LoadState
+									(
+										State::Loader::Subset(loader).Ref(), subId & 0xFF00FFFFUL
+									);
+									break;
+
+								case 'X':
 
-								loader.End();
+									expPort->LoadState
+									(
+										State::Loader::Subset(loader).Ref(), subId & 0xFF00FFFFUL
+									);
+									break;
 							}
 
-							loader.DigOut();
-							break;
-					}
+							loader.End();
+						}
 
-					loader.End();
+						loader.DigOut();
+						break;
 				}
 
-				loader.DigOut();
+				loader.End();
+			}
 
-				return RESULT_OK;
+			loader.DigOut();
+
+			return RESULT_OK;
+		}
+
+		Result Machine::LoadState(StdStream stream,bool checkCrc)
+		{
+			if ((state & (Api::Machine::GAME|Api::Machine::ON)) <= Api::Machine::ON)
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				State::Loader loader( stream );
+				return LoadState( loader, checkCrc );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+		}
+
+		Result Machine::LoadState(const void* data,dword length,bool checkCrc)
+		{
+			if ((state & (Api::Machine::GAME|Api::Machine::ON)) <= Api::Machine::ON)
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				State::Loader loader( data, length );
+				return LoadState( loader, checkCrc );
 			}
 			catch (Result result)
 			{
@@ -448,7 +591,14 @@ namespace Nes
 					extPort->BeginFrame( input );
 					expPort->BeginFrame( input );
 
-					ppu.BeginFrame( video != NULL );
+					// frames left out by the render interval are emulated as
+					// usual, only the pixel output and the blit are dropped,
+					// but a light gun senses the picture itself so it still
+					// gets composed while one is connected
+
+					const bool render = video && (renderInterval == 1 || (renderInterval && frame % renderInterval == 0));
+
+					ppu.BeginFrame( render || LightGunIsConnected() );
 
 					if (cheats)
 						cheats->BeginFrame();
@@ -457,7 +607,7 @@ namespace Nes
 					cpu.ExecuteFrame();
 					ppu.EndFrame();
 
-					if (video)
+					if (render)
 						renderer.Blit( *video, ppu.GetScreen(), ppu.GetBurstPhase() );
 
 					cpu.EndFrame();
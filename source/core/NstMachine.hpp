@@ -56,6 +56,13 @@ namespace Nes
 			class Controllers;
 		}
 
+		namespace State
+		{
+			class Saver;
+			class Loader;
+			class Capture;
+		}
+
 		class Image;
 		class Cheats;
 		class ImageDatabase;
@@ -93,13 +100,19 @@ namespace Nes
 			Result Reset (bool);
 			void   SetMode (Mode);
 			Result LoadState (StdStream,bool=true);
-			Result SaveState (StdStream,bool,bool);
+			Result SaveState (StdStream,uint,bool);
+			Result LoadState (const void*,dword,bool=true);
+			Result SaveState (void*,dword&,uint,bool);
+			Result SaveState (void*,dword&,const void*,dword,bool);
+			Result SaveState (State::Capture&,bool);
 			void   InitializeInputDevices () const;
+			bool   LightGunIsConnected () const;
 			Result UpdateColorMode ();
 			Result UpdateColorMode (ColorMode);
 
 			uint state;
 			ulong frame;
+			uint renderInterval;
 			Input::Adapter* extPort;
 			Input::Device* expPort;
 			Image* image;
@@ -117,6 +130,9 @@ namespace Nes
 
 		private:
 
+			Result LoadState (State::Loader&,bool);
+			void   SaveState (State::Saver&);
+
 			NES_DECL_POKE( 4016 )
 			NES_DECL_PEEK( 4016 )
 			NES_DECL_POKE( 4017 )
@@ -988,7 +988,10 @@ namespace Nes
 			cpu.Map( 0x4018U, 0x5FFFU ).Set( this, &Mapper::Peek_Nop, &Mapper::Poke_Nop );
 
 			if (wrk.RamSize() >= SIZE_8K)
+			{
 				cpu.Map( 0x6000U, 0x7FFFU ).Set( this, &Mapper::Peek_Wrk_6, &Mapper::Poke_Wrk_6 );
+				cpu.MapDirect( 0x6000U, wrk.GetPages() );
+			}
 			else
 				cpu.Map( 0x6000U, 0x7FFFU ).Set( this, &Mapper::Peek_Nop, &Mapper::Poke_Nop );
 
@@ -997,6 +1000,9 @@ namespace Nes
 			cpu.Map( 0xC000U, 0xDFFFU ).Set( this, &Mapper::Peek_Prg_C, &Mapper::Poke_Nop );
 			cpu.Map( 0xE000U, 0xFFFFU ).Set( this, &Mapper::Peek_Prg_E, &Mapper::Poke_Nop );
 
+			for (uint i=0; i < 4; ++i)
+				cpu.MapDirect( 0x8000U + i * SIZE_8K, prg.GetPages() + i );
+
 			cpu.ClearIRQ();
 
 			if (hard)
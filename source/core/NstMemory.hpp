@@ -227,6 +227,11 @@ namespace Nes
 				return pages.mem[page];
 			}
 
+			u8* const* GetPages() const
+			{
+				return pages.mem;
+			}
+
 			void Poke(uint address,uint data)
 			{
 				const uint page = address >> MEM_PAGE_SHIFT;
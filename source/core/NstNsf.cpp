@@ -200,6 +200,8 @@ namespace Nes
 			void Reset();
 			void UpdateContext(uint,const u8 (&w)[MAX_CHANNELS]);
 			Sample GetSample();
+			Sample GetStems(Sample (&)[MAX_CHANNELS]);
+			Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 			Cycle Clock();
 
 			Apu& apu;
@@ -313,6 +315,51 @@ namespace Nes
 			);
 		}
 
+		Apu::Sample Nsf::Chips::GetStems(Sample (&stems)[MAX_CHANNELS])
+		{
+			return
+			(
+				(mmc5 ? stems[Apu::CHANNEL_MMC5] = mmc5->GetSample() : 0) +
+				(vrc6 ? stems[Apu::CHANNEL_VRC6] = vrc6->GetSample() : 0) +
+				(vrc7 ? stems[Apu::CHANNEL_VRC7] = vrc7->GetSample() : 0) +
+				(fds  ? stems[Apu::CHANNEL_FDS]  = fds->GetSample()  : 0) +
+				(s5b  ? stems[Apu::CHANNEL_S5B]  = s5b->GetSample()  : 0) +
+				(n106 ? stems[Apu::CHANNEL_N106] = n106->GetSample() : 0)
+			);
+		}
+
+		Cycle Nsf::Chips::Render(Sample* const output,const uint length,const Cycle clock,const Cycle period,Cycle next)
+		{
+			// MMC5 and FDS together share the one clock, see Clock()
+
+			if (mmc5 && fds)
+				return Channel::Render( output, length, clock, period, next );
+
+			Channel* const list[] = { mmc5, vrc6, vrc7, fds, s5b, n106 };
+
+			for (uint i=0; i < length; i += BLOCK_SIZE)
+			{
+				const uint count = NST_MIN(length-i,uint(BLOCK_SIZE));
+				Sample block[BLOCK_SIZE];
+
+				for (uint j=0; j < count; ++j)
+					output[i+j] = 0;
+
+				for (uint k=0; k < NST_COUNT(list); ++k)
+				{
+					if (list[k])
+					{
+						next = list[k]->Render( block, count, clock + i * period, period, next );
+
+						for (uint j=0; j < count; ++j)
+							output[i+j] += block[j];
+					}
+				}
+			}
+
+			return next;
+		}
+
 		Nsf::Nsf(Context& context)
 		:
 		Image    (SOUND),
@@ -69,183 +69,268 @@ namespace Nes
 			0x1F,0x9F,0x5F,0xDF,0x3F,0xBF,0x7F,0xFF
 		};
 
-		static const union { u8 pixels[4]; u32 block; } chrLut[2][16] =
-		{
-			{
-				{0x00,0x00,0x00,0x00},
-				{0x01,0x00,0x00,0x00},
-				{0x00,0x01,0x00,0x00},
-				{0x01,0x01,0x00,0x00},
-				{0x00,0x00,0x01,0x00},
-				{0x01,0x00,0x01,0x00},
-				{0x00,0x01,0x01,0x00},
-				{0x01,0x01,0x01,0x00},
-				{0x00,0x00,0x00,0x01},
-				{0x01,0x00,0x00,0x01},
-				{0x00,0x01,0x00,0x01},
-				{0x01,0x01,0x00,0x01},
-				{0x00,0x00,0x01,0x01},
-				{0x01,0x00,0x01,0x01},
-				{0x00,0x01,0x01,0x01},
-				{0x01,0x01,0x01,0x01}
-			},
-			{
-				{0x00,0x00,0x00,0x00},
-				{0x02,0x00,0x00,0x00},
-				{0x00,0x02,0x00,0x00},
-				{0x02,0x02,0x00,0x00},
-				{0x00,0x00,0x02,0x00},
-				{0x02,0x00,0x02,0x00},
-				{0x00,0x02,0x02,0x00},
-				{0x02,0x02,0x02,0x00},
-				{0x00,0x00,0x00,0x02},
-				{0x02,0x00,0x00,0x02},
-				{0x00,0x02,0x00,0x02},
-				{0x02,0x02,0x00,0x02},
-				{0x00,0x00,0x02,0x02},
-				{0x02,0x00,0x02,0x02},
-				{0x00,0x02,0x02,0x02},
-				{0x02,0x02,0x02,0x02}
-			}
-		};
-
-		static const union { u8 pixels[4]; u32 block; } chrAttLut[2][64] =
-		{
-			{
-				{0x00,0x00,0x00,0x00},
-				{0x01,0x00,0x00,0x00},
-				{0x00,0x01,0x00,0x00},
-				{0x01,0x01,0x00,0x00},
-				{0x00,0x00,0x01,0x00},
-				{0x01,0x00,0x01,0x00},
-				{0x00,0x01,0x01,0x00},
-				{0x01,0x01,0x01,0x00},
-				{0x00,0x00,0x00,0x01},
-				{0x01,0x00,0x00,0x01},
-				{0x00,0x01,0x00,0x01},
-				{0x01,0x01,0x00,0x01},
-				{0x00,0x00,0x01,0x01},
-				{0x01,0x00,0x01,0x01},
-				{0x00,0x01,0x01,0x01},
-				{0x01,0x01,0x01,0x01},
-				{0x00,0x00,0x00,0x00},
-				{0x05,0x00,0x00,0x00},
-				{0x00,0x05,0x00,0x00},
-				{0x05,0x05,0x00,0x00},
-				{0x00,0x00,0x05,0x00},
-				{0x05,0x00,0x05,0x00},
-				{0x00,0x05,0x05,0x00},
-				{0x05,0x05,0x05,0x00},
-				{0x00,0x00,0x00,0x05},
-				{0x05,0x00,0x00,0x05},
-				{0x00,0x05,0x00,0x05},
-				{0x05,0x05,0x00,0x05},
-				{0x00,0x00,0x05,0x05},
-				{0x05,0x00,0x05,0x05},
-				{0x00,0x05,0x05,0x05},
-				{0x05,0x05,0x05,0x05},
-				{0x00,0x00,0x00,0x00},
-				{0x09,0x00,0x00,0x00},
-				{0x00,0x09,0x00,0x00},
-				{0x09,0x09,0x00,0x00},
-				{0x00,0x00,0x09,0x00},
-				{0x09,0x00,0x09,0x00},
-				{0x00,0x09,0x09,0x00},
-				{0x09,0x09,0x09,0x00},
-				{0x00,0x00,0x00,0x09},
-				{0x09,0x00,0x00,0x09},
-				{0x00,0x09,0x00,0x09},
-				{0x09,0x09,0x00,0x09},
-				{0x00,0x00,0x09,0x09},
-				{0x09,0x00,0x09,0x09},
-				{0x00,0x09,0x09,0x09},
-				{0x09,0x09,0x09,0x09},
-				{0x00,0x00,0x00,0x00},
-				{0x0D,0x00,0x00,0x00},
-				{0x00,0x0D,0x00,0x00},
-				{0x0D,0x0D,0x00,0x00},
-				{0x00,0x00,0x0D,0x00},
-				{0x0D,0x00,0x0D,0x00},
-				{0x00,0x0D,0x0D,0x00},
-				{0x0D,0x0D,0x0D,0x00},
-				{0x00,0x00,0x00,0x0D},
-				{0x0D,0x00,0x00,0x0D},
-				{0x00,0x0D,0x00,0x0D},
-				{0x0D,0x0D,0x00,0x0D},
-				{0x00,0x00,0x0D,0x0D},
-				{0x0D,0x00,0x0D,0x0D},
-				{0x00,0x0D,0x0D,0x0D},
-				{0x0D,0x0D,0x0D,0x0D}
-			},
-			{
-				{0x00,0x00,0x00,0x00},
-				{0x02,0x00,0x00,0x00},
-				{0x00,0x02,0x00,0x00},
-				{0x02,0x02,0x00,0x00},
-				{0x00,0x00,0x02,0x00},
-				{0x02,0x00,0x02,0x00},
-				{0x00,0x02,0x02,0x00},
-				{0x02,0x02,0x02,0x00},
-				{0x00,0x00,0x00,0x02},
-				{0x02,0x00,0x00,0x02},
-				{0x00,0x02,0x00,0x02},
-				{0x02,0x02,0x00,0x02},
-				{0x00,0x00,0x02,0x02},
-				{0x02,0x00,0x02,0x02},
-				{0x00,0x02,0x02,0x02},
-				{0x02,0x02,0x02,0x02},
-				{0x00,0x00,0x00,0x00},
-				{0x06,0x00,0x00,0x00},
-				{0x00,0x06,0x00,0x00},
-				{0x06,0x06,0x00,0x00},
-				{0x00,0x00,0x06,0x00},
-				{0x06,0x00,0x06,0x00},
-				{0x00,0x06,0x06,0x00},
-				{0x06,0x06,0x06,0x00},
-				{0x00,0x00,0x00,0x06},
-				{0x06,0x00,0x00,0x06},
-				{0x00,0x06,0x00,0x06},
-				{0x06,0x06,0x00,0x06},
-				{0x00,0x00,0x06,0x06},
-				{0x06,0x00,0x06,0x06},
-				{0x00,0x06,0x06,0x06},
-				{0x06,0x06,0x06,0x06},
-				{0x00,0x00,0x00,0x00},
-				{0x0A,0x00,0x00,0x00},
-				{0x00,0x0A,0x00,0x00},
-				{0x0A,0x0A,0x00,0x00},
-				{0x00,0x00,0x0A,0x00},
-				{0x0A,0x00,0x0A,0x00},
-				{0x00,0x0A,0x0A,0x00},
-				{0x0A,0x0A,0x0A,0x00},
-				{0x00,0x00,0x00,0x0A},
-				{0x0A,0x00,0x00,0x0A},
-				{0x00,0x0A,0x00,0x0A},
-				{0x0A,0x0A,0x00,0x0A},
-				{0x00,0x00,0x0A,0x0A},
-				{0x0A,0x00,0x0A,0x0A},
-				{0x00,0x0A,0x0A,0x0A},
-				{0x0A,0x0A,0x0A,0x0A},
-				{0x00,0x00,0x00,0x00},
-				{0x0E,0x00,0x00,0x00},
-				{0x00,0x0E,0x00,0x00},
-				{0x0E,0x0E,0x00,0x00},
-				{0x00,0x00,0x0E,0x00},
-				{0x0E,0x00,0x0E,0x00},
-				{0x00,0x0E,0x0E,0x00},
-				{0x0E,0x0E,0x0E,0x00},
-				{0x00,0x00,0x00,0x0E},
-				{0x0E,0x00,0x00,0x0E},
-				{0x00,0x0E,0x00,0x0E},
-				{0x0E,0x0E,0x00,0x0E},
-				{0x00,0x00,0x0E,0x0E},
-				{0x0E,0x00,0x0E,0x0E},
-				{0x00,0x0E,0x0E,0x0E},
-				{0x0E,0x0E,0x0E,0x0E}
-			}
+		// one pattern byte decoded into its eight pixels, leftmost first
+
+		static const union { u8 pixels[8]; u32 block[2]; } patternLut[256] =
+		{
+			{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+			{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01},
+			{0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00},
+			{0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x01},
+			{0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00},
+			{0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x01},
+			{0x00,0x00,0x00,0x00,0x00,0x01,0x01,0x00},
+			{0x00,0x00,0x00,0x00,0x00,0x01,0x01,0x01},
+			{0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00},
+			{0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x01},
+			{0x00,0x00,0x00,0x00,0x01,0x00,0x01,0x00},
+			{0x00,0x00,0x00,0x00,0x01,0x00,0x01,0x01},
+			{0x00,0x00,0x00,0x00,0x01,0x01,0x00,0x00},
+			{0x00,0x00,0x00,0x00,0x01,0x01,0x00,0x01},
+			{0x00,0x00,0x00,0x00,0x01,0x01,0x01,0x00},
+			{0x00,0x00,0x00,0x00,0x01,0x01,0x01,0x01},
+			{0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00},
+			{0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x01},
+			{0x00,0x00,0x00,0x01,0x00,0x00,0x01,0x00},
+			{0x00,0x00,0x00,0x01,0x00,0x00,0x01,0x01},
+			{0x00,0x00,0x00,0x01,0x00,0x01,0x00,0x00},
+			{0x00,0x00,0x00,0x01,0x00,0x01,0x00,0x01},
+			{0x00,0x00,0x00,0x01,0x00,0x01,0x01,0x00},
+			{0x00,0x00,0x00,0x01,0x00,0x01,0x01,0x01},
+			{0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x00},
+			{0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x01},
+			{0x00,0x00,0x00,0x01,0x01,0x00,0x01,0x00},
+			{0x00,0x00,0x00,0x01,0x01,0x00,0x01,0x01},
+			{0x00,0x00,0x00,0x01,0x01,0x01,0x00,0x00},
+			{0x00,0x00,0x00,0x01,0x01,0x01,0x00,0x01},
+			{0x00,0x00,0x00,0x01,0x01,0x01,0x01,0x00},
+			{0x00,0x00,0x00,0x01,0x01,0x01,0x01,0x01},
+			{0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00},
+			{0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x01},
+			{0x00,0x00,0x01,0x00,0x00,0x00,0x01,0x00},
+			{0x00,0x00,0x01,0x00,0x00,0x00,0x01,0x01},
+			{0x00,0x00,0x01,0x00,0x00,0x01,0x00,0x00},
+			{0x00,0x00,0x01,0x00,0x00,0x01,0x00,0x01},
+			{0x00,0x00,0x01,0x00,0x00,0x01,0x01,0x00},
+			{0x00,0x00,0x01,0x00,0x00,0x01,0x01,0x01},
+			{0x00,0x00,0x01,0x00,0x01,0x00,0x00,0x00},
+			{0x00,0x00,0x01,0x00,0x01,0x00,0x00,0x01},
+			{0x00,0x00,0x01,0x00,0x01,0x00,0x01,0x00},
+			{0x00,0x00,0x01,0x00,0x01,0x00,0x01,0x01},
+			{0x00,0x00,0x01,0x00,0x01,0x01,0x00,0x00},
+			{0x00,0x00,0x01,0x00,0x01,0x01,0x00,0x01},
+			{0x00,0x00,0x01,0x00,0x01,0x01,0x01,0x00},
+			{0x00,0x00,0x01,0x00,0x01,0x01,0x01,0x01},
+			{0x00,0x00,0x01,0x01,0x00,0x00,0x00,0x00},
+			{0x00,0x00,0x01,0x01,0x00,0x00,0x00,0x01},
+			{0x00,0x00,0x01,0x01,0x00,0x00,0x01,0x00},
+			{0x00,0x00,0x01,0x01,0x00,0x00,0x01,0x01},
+			{0x00,0x00,0x01,0x01,0x00,0x01,0x00,0x00},
+			{0x00,0x00,0x01,0x01,0x00,0x01,0x00,0x01},
+			{0x00,0x00,0x01,0x01,0x00,0x01,0x01,0x00},
+			{0x00,0x00,0x01,0x01,0x00,0x01,0x01,0x01},
+			{0x00,0x00,0x01,0x01,0x01,0x00,0x00,0x00},
+			{0x00,0x00,0x01,0x01,0x01,0x00,0x00,0x01},
+			{0x00,0x00,0x01,0x01,0x01,0x00,0x01,0x00},
+			{0x00,0x00,0x01,0x01,0x01,0x00,0x01,0x01},
+			{0x00,0x00,0x01,0x01,0x01,0x01,0x00,0x00},
+			{0x00,0x00,0x01,0x01,0x01,0x01,0x00,0x01},
+			{0x00,0x00,0x01,0x01,0x01,0x01,0x01,0x00},
+			{0x00,0x00,0x01,0x01,0x01,0x01,0x01,0x01},
+			{0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00},
+			{0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x01},
+			{0x00,0x01,0x00,0x00,0x00,0x00,0x01,0x00},
+			{0x00,0x01,0x00,0x00,0x00,0x00,0x01,0x01},
+			{0x00,0x01,0x00,0x00,0x00,0x01,0x00,0x00},
+			{0x00,0x01,0x00,0x00,0x00,0x01,0x00,0x01},
+			{0x00,0x01,0x00,0x00,0x00,0x01,0x01,0x00},
+			{0x00,0x01,0x00,0x00,0x00,0x01,0x01,0x01},
+			{0x00,0x01,0x00,0x00,0x01,0x00,0x00,0x00},
+			{0x00,0x01,0x00,0x00,0x01,0x00,0x00,0x01},
+			{0x00,0x01,0x00,0x00,0x01,0x00,0x01,0x00},
+			{0x00,0x01,0x00,0x00,0x01,0x00,0x01,0x01},
+			{0x00,0x01,0x00,0x00,0x01,0x01,0x00,0x00},
+			{0x00,0x01,0x00,0x00,0x01,0x01,0x00,0x01},
+			{0x00,0x01,0x00,0x00,0x01,0x01,0x01,0x00},
+			{0x00,0x01,0x00,0x00,0x01,0x01,0x01,0x01},
+			{0x00,0x01,0x00,0x01,0x00,0x00,0x00,0x00},
+			{0x00,0x01,0x00,0x01,0x00,0x00,0x00,0x01},
+			{0x00,0x01,0x00,0x01,0x00,0x00,0x01,0x00},
+			{0x00,0x01,0x00,0x01,0x00,0x00,0x01,0x01},
+			{0x00,0x01,0x00,0x01,0x00,0x01,0x00,0x00},
+			{0x00,0x01,0x00,0x01,0x00,0x01,0x00,0x01},
+			{0x00,0x01,0x00,0x01,0x00,0x01,0x01,0x00},
+			{0x00,0x01,0x00,0x01,0x00,0x01,0x01,0x01},
+			{0x00,0x01,0x00,0x01,0x01,0x00,0x00,0x00},
+			{0x00,0x01,0x00,0x01,0x01,0x00,0x00,0x01},
+			{0x00,0x01,0x00,0x01,0x01,0x00,0x01,0x00},
+			{0x00,0x01,0x00,0x01,0x01,0x00,0x01,0x01},
+			{0x00,0x01,0x00,0x01,0x01,0x01,0x00,0x00},
+			{0x00,0x01,0x00,0x01,0x01,0x01,0x00,0x01},
+			{0x00,0x01,0x00,0x01,0x01,0x01,0x01,0x00},
+			{0x00,0x01,0x00,0x01,0x01,0x01,0x01,0x01},
+			{0x00,0x01,0x01,0x00,0x00,0x00,0x00,0x00},
+			{0x00,0x01,0x01,0x00,0x00,0x00,0x00,0x01},
+			{0x00,0x01,0x01,0x00,0x00,0x00,0x01,0x00},
+			{0x00,0x01,0x01,0x00,0x00,0x00,0x01,0x01},
+			{0x00,0x01,0x01,0x00,0x00,0x01,0x00,0x00},
+			{0x00,0x01,0x01,0x00,0x00,0x01,0x00,0x01},
+			{0x00,0x01,0x01,0x00,0x00,0x01,0x01,0x00},
+			{0x00,0x01,0x01,0x00,0x00,0x01,0x01,0x01},
+			{0x00,0x01,0x01,0x00,0x01,0x00,0x00,0x00},
+			{0x00,0x01,0x01,0x00,0x01,0x00,0x00,0x01},
+			{0x00,0x01,0x01,0x00,0x01,0x00,0x01,0x00},
+			{0x00,0x01,0x01,0x00,0x01,0x00,0x01,0x01},
+			{0x00,0x01,0x01,0x00,0x01,0x01,0x00,0x00},
+			{0x00,0x01,0x01,0x00,0x01,0x01,0x00,0x01},
+			{0x00,0x01,0x01,0x00,0x01,0x01,0x01,0x00},
+			{0x00,0x01,0x01,0x00,0x01,0x01,0x01,0x01},
+			{0x00,0x01,0x01,0x01,0x00,0x00,0x00,0x00},
+			{0x00,0x01,0x01,0x01,0x00,0x00,0x00,0x01},
+			{0x00,0x01,0x01,0x01,0x00,0x00,0x01,0x00},
+			{0x00,0x01,0x01,0x01,0x00,0x00,0x01,0x01},
+			{0x00,0x01,0x01,0x01,0x00,0x01,0x00,0x00},
+			{0x00,0x01,0x01,0x01,0x00,0x01,0x00,0x01},
+			{0x00,0x01,0x01,0x01,0x00,0x01,0x01,0x00},
+			{0x00,0x01,0x01,0x01,0x00,0x01,0x01,0x01},
+			{0x00,0x01,0x01,0x01,0x01,0x00,0x00,0x00},
+			{0x00,0x01,0x01,0x01,0x01,0x00,0x00,0x01},
+			{0x00,0x01,0x01,0x01,0x01,0x00,0x01,0x00},
+			{0x00,0x01,0x01,0x01,0x01,0x00,0x01,0x01},
+			{0x00,0x01,0x01,0x01,0x01,0x01,0x00,0x00},
+			{0x00,0x01,0x01,0x01,0x01,0x01,0x00,0x01},
+			{0x00,0x01,0x01,0x01,0x01,0x01,0x01,0x00},
+			{0x00,0x01,0x01,0x01,0x01,0x01,0x01,0x01},
+			{0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+			{0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x01},
+			{0x01,0x00,0x00,0x00,0x00,0x00,0x01,0x00},
+			{0x01,0x00,0x00,0x00,0x00,0x00,0x01,0x01},
+			{0x01,0x00,0x00,0x00,0x00,0x01,0x00,0x00},
+			{0x01,0x00,0x00,0x00,0x00,0x01,0x00,0x01},
+			{0x01,0x00,0x00,0x00,0x00,0x01,0x01,0x00},
+			{0x01,0x00,0x00,0x00,0x00,0x01,0x01,0x01},
+			{0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00},
+			{0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x01},
+			{0x01,0x00,0x00,0x00,0x01,0x00,0x01,0x00},
+			{0x01,0x00,0x00,0x00,0x01,0x00,0x01,0x01},
+			{0x01,0x00,0x00,0x00,0x01,0x01,0x00,0x00},
+			{0x01,0x00,0x00,0x00,0x01,0x01,0x00,0x01},
+			{0x01,0x00,0x00,0x00,0x01,0x01,0x01,0x00},
+			{0x01,0x00,0x00,0x00,0x01,0x01,0x01,0x01},
+			{0x01,0x00,0x00,0x01,0x00,0x00,0x00,0x00},
+			{0x01,0x00,0x00,0x01,0x00,0x00,0x00,0x01},
+			{0x01,0x00,0x00,0x01,0x00,0x00,0x01,0x00},
+			{0x01,0x00,0x00,0x01,0x00,0x00,0x01,0x01},
+			{0x01,0x00,0x00,0x01,0x00,0x01,0x00,0x00},
+			{0x01,0x00,0x00,0x01,0x00,0x01,0x00,0x01},
+			{0x01,0x00,0x00,0x01,0x00,0x01,0x01,0x00},
+			{0x01,0x00,0x00,0x01,0x00,0x01,0x01,0x01},
+			{0x01,0x00,0x00,0x01,0x01,0x00,0x00,0x00},
+			{0x01,0x00,0x00,0x01,0x01,0x00,0x00,0x01},
+			{0x01,0x00,0x00,0x01,0x01,0x00,0x01,0x00},
+			{0x01,0x00,0x00,0x01,0x01,0x00,0x01,0x01},
+			{0x01,0x00,0x00,0x01,0x01,0x01,0x00,0x00},
+			{0x01,0x00,0x00,0x01,0x01,0x01,0x00,0x01},
+			{0x01,0x00,0x00,0x01,0x01,0x01,0x01,0x00},
+			{0x01,0x00,0x00,0x01,0x01,0x01,0x01,0x01},
+			{0x01,0x00,0x01,0x00,0x00,0x00,0x00,0x00},
+			{0x01,0x00,0x01,0x00,0x00,0x00,0x00,0x01},
+			{0x01,0x00,0x01,0x00,0x00,0x00,0x01,0x00},
+			{0x01,0x00,0x01,0x00,0x00,0x00,0x01,0x01},
+			{0x01,0x00,0x01,0x00,0x00,0x01,0x00,0x00},
+			{0x01,0x00,0x01,0x00,0x00,0x01,0x00,0x01},
+			{0x01,0x00,0x01,0x00,0x00,0x01,0x01,0x00},
+			{0x01,0x00,0x01,0x00,0x00,0x01,0x01,0x01},
+			{0x01,0x00,0x01,0x00,0x01,0x00,0x00,0x00},
+			{0x01,0x00,0x01,0x00,0x01,0x00,0x00,0x01},
+			{0x01,0x00,0x01,0x00,0x01,0x00,0x01,0x00},
+			{0x01,0x00,0x01,0x00,0x01,0x00,0x01,0x01},
+			{0x01,0x00,0x01,0x00,0x01,0x01,0x00,0x00},
+			{0x01,0x00,0x01,0x00,0x01,0x01,0x00,0x01},
+			{0x01,0x00,0x01,0x00,0x01,0x01,0x01,0x00},
+			{0x01,0x00,0x01,0x00,0x01,0x01,0x01,0x01},
+			{0x01,0x00,0x01,0x01,0x00,0x00,0x00,0x00},
+			{0x01,0x00,0x01,0x01,0x00,0x00,0x00,0x01},
+			{0x01,0x00,0x01,0x01,0x00,0x00,0x01,0x00},
+			{0x01,0x00,0x01,0x01,0x00,0x00,0x01,0x01},
+			{0x01,0x00,0x01,0x01,0x00,0x01,0x00,0x00},
+			{0x01,0x00,0x01,0x01,0x00,0x01,0x00,0x01},
+			{0x01,0x00,0x01,0x01,0x00,0x01,0x01,0x00},
+			{0x01,0x00,0x01,0x01,0x00,0x01,0x01,0x01},
+			{0x01,0x00,0x01,0x01,0x01,0x00,0x00,0x00},
+			{0x01,0x00,0x01,0x01,0x01,0x00,0x00,0x01},
+			{0x01,0x00,0x01,0x01,0x01,0x00,0x01,0x00},
+			{0x01,0x00,0x01,0x01,0x01,0x00,0x01,0x01},
+			{0x01,0x00,0x01,0x01,0x01,0x01,0x00,0x00},
+			{0x01,0x00,0x01,0x01,0x01,0x01,0x00,0x01},
+			{0x01,0x00,0x01,0x01,0x01,0x01,0x01,0x00},
+			{0x01,0x00,0x01,0x01,0x01,0x01,0x01,0x01},
+			{0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00},
+			{0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x01},
+			{0x01,0x01,0x00,0x00,0x00,0x00,0x01,0x00},
+			{0x01,0x01,0x00,0x00,0x00,0x00,0x01,0x01},
+			{0x01,0x01,0x00,0x00,0x00,0x01,0x00,0x00},
+			{0x01,0x01,0x00,0x00,0x00,0x01,0x00,0x01},
+			{0x01,0x01,0x00,0x00,0x00,0x01,0x01,0x00},
+			{0x01,0x01,0x00,0x00,0x00,0x01,0x01,0x01},
+			{0x01,0x01,0x00,0x00,0x01,0x00,0x00,0x00},
+			{0x01,0x01,0x00,0x00,0x01,0x00,0x00,0x01},
+			{0x01,0x01,0x00,0x00,0x01,0x00,0x01,0x00},
+			{0x01,0x01,0x00,0x00,0x01,0x00,0x01,0x01},
+			{0x01,0x01,0x00,0x00,0x01,0x01,0x00,0x00},
+			{0x01,0x01,0x00,0x00,0x01,0x01,0x00,0x01},
+			{0x01,0x01,0x00,0x00,0x01,0x01,0x01,0x00},
+			{0x01,0x01,0x00,0x00,0x01,0x01,0x01,0x01},
+			{0x01,0x01,0x00,0x01,0x00,0x00,0x00,0x00},
+			{0x01,0x01,0x00,0x01,0x00,0x00,0x00,0x01},
+			{0x01,0x01,0x00,0x01,0x00,0x00,0x01,0x00},
+			{0x01,0x01,0x00,0x01,0x00,0x00,0x01,0x01},
+			{0x01,0x01,0x00,0x01,0x00,0x01,0x00,0x00},
+			{0x01,0x01,0x00,0x01,0x00,0x01,0x00,0x01},
+			{0x01,0x01,0x00,0x01,0x00,0x01,0x01,0x00},
+			{0x01,0x01,0x00,0x01,0x00,0x01,0x01,0x01},
+			{0x01,0x01,0x00,0x01,0x01,0x00,0x00,0x00},
+			{0x01,0x01,0x00,0x01,0x01,0x00,0x00,0x01},
+			{0x01,0x01,0x00,0x01,0x01,0x00,0x01,0x00},
+			{0x01,0x01,0x00,0x01,0x01,0x00,0x01,0x01},
+			{0x01,0x01,0x00,0x01,0x01,0x01,0x00,0x00},
+			{0x01,0x01,0x00,0x01,0x01,0x01,0x00,0x01},
+			{0x01,0x01,0x00,0x01,0x01,0x01,0x01,0x00},
+			{0x01,0x01,0x00,0x01,0x01,0x01,0x01,0x01},
+			{0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x00},
+			{0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x01},
+			{0x01,0x01,0x01,0x00,0x00,0x00,0x01,0x00},
+			{0x01,0x01,0x01,0x00,0x00,0x00,0x01,0x01},
+			{0x01,0x01,0x01,0x00,0x00,0x01,0x00,0x00},
+			{0x01,0x01,0x01,0x00,0x00,0x01,0x00,0x01},
+			{0x01,0x01,0x01,0x00,0x00,0x01,0x01,0x00},
+			{0x01,0x01,0x01,0x00,0x00,0x01,0x01,0x01},
+			{0x01,0x01,0x01,0x00,0x01,0x00,0x00,0x00},
+			{0x01,0x01,0x01,0x00,0x01,0x00,0x00,0x01},
+			{0x01,0x01,0x01,0x00,0x01,0x00,0x01,0x00},
+			{0x01,0x01,0x01,0x00,0x01,0x00,0x01,0x01},
+			{0x01,0x01,0x01,0x00,0x01,0x01,0x00,0x00},
+			{0x01,0x01,0x01,0x00,0x01,0x01,0x00,0x01},
+			{0x01,0x01,0x01,0x00,0x01,0x01,0x01,0x00},
+			{0x01,0x01,0x01,0x00,0x01,0x01,0x01,0x01},
+			{0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x00},
+			{0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x01},
+			{0x01,0x01,0x01,0x01,0x00,0x00,0x01,0x00},
+			{0x01,0x01,0x01,0x01,0x00,0x00,0x01,0x01},
+			{0x01,0x01,0x01,0x01,0x00,0x01,0x00,0x00},
+			{0x01,0x01,0x01,0x01,0x00,0x01,0x00,0x01},
+			{0x01,0x01,0x01,0x01,0x00,0x01,0x01,0x00},
+			{0x01,0x01,0x01,0x01,0x00,0x01,0x01,0x01},
+			{0x01,0x01,0x01,0x01,0x01,0x00,0x00,0x00},
+			{0x01,0x01,0x01,0x01,0x01,0x00,0x00,0x01},
+			{0x01,0x01,0x01,0x01,0x01,0x00,0x01,0x00},
+			{0x01,0x01,0x01,0x01,0x01,0x00,0x01,0x01},
+			{0x01,0x01,0x01,0x01,0x01,0x01,0x00,0x00},
+			{0x01,0x01,0x01,0x01,0x01,0x01,0x00,0x01},
+			{0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x00},
+			{0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01}
 		};
 
-		dword Ppu::logged;
 		u16 Ppu::Output::dummy[4];
 
 		#ifdef NST_PRAGMA_OPTIMIZE
@@ -286,7 +371,8 @@ namespace Nes
 		output (screen.pixels),
 		bgHook (this,&Ppu::Hook_Nop),
 		spHook (this,&Ppu::Hook_Nop),
-		yuvMap (NULL)
+		yuvMap (NULL),
+		logged (0)
 		{
 			oam.limit = oam.buffer + Oam::STD_LINE_SPRITES;
 			SetMode( cpu.GetMode() );
@@ -318,6 +404,7 @@ namespace Nes
 			}
 
 			cpu.Map( 0x4014U ).Set( this, &Ppu::Peek_4014, &Ppu::Poke_4014 );
+			cpu.MapVBlankPoll( 0x2002 );
 
 			SetYuvMap( NULL, false );
 
@@ -392,8 +479,10 @@ namespace Nes
 			tiles.pad = 0;
 
 			oam.address = 0;
-			oam.visible = oam.output;
+			oam.visible = 0;
 			oam.evaluated = oam.buffer;
+
+			std::memset( oam.line, 0, sizeof(oam.line) );
 			oam.loaded = oam.buffer;
 
 			UpdateStates();
@@ -473,8 +562,14 @@ namespace Nes
 			state.Begin('N','M','T','\0').Compress( nameTable.ram ).End();
 
 			if (cpu.GetMode() == MODE_NTSC)
+			{
 				state.Begin('F','R','M','\0').Write8( (regs.frame & Regs::FRAME_ODD) == 0 ).End();
 
+				// ntsc filter color phase, older states start it over
+
+				state.Begin('B','S','T','\0').Write8( output.burstPhase ).End();
+			}
+
 			if (phase == &Ppu::WarmUp)
 				state.Begin('P','O','W','\0').Write8( WARM_UP_FRAMES-stage ).End();
 		}
@@ -530,6 +625,13 @@ namespace Nes
 
 						break;
 
+					case NES_STATE_CHUNK_ID('B','S','T','\0'):
+
+						if (cpu.GetMode() == MODE_NTSC)
+							output.burstPhase = state.Read8() % 3;
+
+						break;
+
 					case NES_STATE_CHUNK_ID('P','O','W','\0'):
 
 						stage = uint(WARM_UP_FRAMES) - (state.Read8() & 0x7U);
@@ -1262,31 +1364,42 @@ namespace Nes
 
 			if (pattern[0] | pattern[1])
 			{
-				if (!(oam.loaded->attribute & Oam::X_FLIP))
+				if (oam.loaded->attribute & Oam::X_FLIP)
 				{
 					pattern[0] = reverseLut[pattern[0]];
 					pattern[1] = reverseLut[pattern[1]];
 				}
 
-				const u32 block[] =
+				union
 				{
-					chrLut[0][pattern[0] & 0xF].block |
-					chrLut[1][pattern[1] & 0xF].block,
-					chrLut[0][pattern[0] >>  4].block |
-					chrLut[1][pattern[1] >>  4].block
-				};
-
-				Oam::Output* const NST_RESTRICT output = oam.visible++;
+					u8 pixels[8];
+					u32 block[2];
+				}   sprite;
 
-				output->block[0] = block[0];
-				output->block[1] = block[1];
+				sprite.block[0] = patternLut[pattern[0]].block[0] | patternLut[pattern[1]].block[0] << 1;
+				sprite.block[1] = patternLut[pattern[0]].block[1] | patternLut[pattern[1]].block[1] << 1;
 
 				const uint attribute = oam.loaded->attribute;
 
-				output->x       = oam.loaded->x;
-				output->palette = Palette::SPRITE_OFFSET + (attribute & (uint(Oam::COLOR) << 2));
-				output->zero    = (attribute & 0x1) ? b11 : b00;
-				output->behind  = (attribute & Oam::BEHIND) ? b11 : b00;
+				const uint flags =
+				(
+					(attribute & (uint(Oam::COLOR) << 2)) |
+					((attribute & Oam::BEHIND) ? uint(Oam::LINE_BEHIND) : 0U) |
+					((attribute & 0x1) ? uint(Oam::LINE_ZERO) : 0U)
+				);
+
+				// sprites are loaded in priority order, the
+				// first opaque pixel on a given dot wins
+
+				u8* const NST_RESTRICT line = oam.line + oam.loaded->x;
+
+				for (uint i=0; i < 8; ++i)
+				{
+					if (sprite.pixels[i] && !line[i])
+						line[i] = flags | sprite.pixels[i];
+				}
+
+				oam.visible |= Oam::VISIBLE_SPRITES | ((attribute & 0x1) ? uint(Oam::VISIBLE_ZERO) : 0U);
 			}
 
 			++oam.loaded;
@@ -1294,12 +1407,16 @@ namespace Nes
 
 		NST_FORCE_INLINE void Ppu::Tiles::Load()
 		{
+			// pixels are 0 or 1 per byte in each plane, the attribute
+			// bits are multiplied in wherever either plane is set
+
+			const u32 (&lo)[2] = patternLut[pattern[0]].block;
+			const u32 (&hi)[2] = patternLut[pattern[1]].block;
+
 			const u32 tmp[] =
 			{
-				chrAttLut[0][(reverseLut[pattern[0]] & 0xF) | (attribute << 4)].block |
-				chrAttLut[1][(reverseLut[pattern[1]] & 0xF) | (attribute << 4)].block,
-				chrAttLut[0][(reverseLut[pattern[0]] >>  4) | (attribute << 4)].block |
-				chrAttLut[1][(reverseLut[pattern[1]] >>  4) | (attribute << 4)].block
+				lo[0] | hi[0] << 1 | (lo[0] | hi[0]) * (attribute << 2),
+				lo[1] | hi[1] << 1 | (lo[1] | hi[1]) * (attribute << 2)
 			};
 
 			u32* const NST_RESTRICT dst = reinterpret_cast<u32*>(pixels + index);
@@ -1311,36 +1428,38 @@ namespace Nes
 
 		NST_FORCE_INLINE void Ppu::RenderPixel()
 		{
-			register uint pixel = 0;
-
-			if (io.enabled)
+			if (!output.next)
 			{
-				pixel = tiles.pixels[(output.index + scroll.xFine) & 15] & tiles.show & tiles.clip;
-
-				const Oam::Output* NST_RESTRICT sprite = oam.output;
+				// nothing is shown, only look for sprite 0 hits
 
-				for (const Oam::Output* const end = oam.visible; sprite != end; ++sprite)
+				if (io.enabled && (oam.visible & Oam::VISIBLE_ZERO))
 				{
-					register uint x = (output.index & 0xFF) - sprite->x;
+					const uint sprite = oam.line[output.index & 0xFF] & oam.show & oam.clip;
 
-					if (x > 7)
-						continue;
+					if (tiles.pixels[(output.index + scroll.xFine) & 15] & tiles.show & tiles.clip & sprite >> 6)
+						regs.status |= Regs::STATUS_SP_ZERO_HIT;
+				}
 
-					x = sprite->pixels[x] & oam.show & oam.clip;
+				++output.index;
+				return;
+			}
 
-					if (x)
-					{
-						// first two bits of sprite->zero and sprite->behind booleans
-						// are masked if true (for minimizing branching)
+			register uint pixel = 0;
 
-						if (pixel & sprite->zero)
-							regs.status |= Regs::STATUS_SP_ZERO_HIT;
+			if (io.enabled)
+			{
+				pixel = tiles.pixels[(output.index + scroll.xFine) & 15] & tiles.show & tiles.clip;
 
-						if (!(pixel & sprite->behind))
-							pixel = sprite->palette + x;
+				if (const uint sprite = oam.line[output.index & 0xFF] & oam.show & oam.clip)
+				{
+					// the sprite-0 and behind flags are stored as two set bits
+					// each, shifted down they mask the background color
 
-						break;
-					}
+					if (pixel & sprite >> 6)
+						regs.status |= Regs::STATUS_SP_ZERO_HIT;
+
+					if (!(pixel & sprite >> 4 & 0x3))
+						pixel = Palette::SPRITE_OFFSET + (sprite & Oam::LINE_COLOR);
 				}
 			}
 			else if ((scroll.address & 0x3F00) == 0x3F00)
@@ -1356,6 +1475,12 @@ namespace Nes
 
 		void Ppu::HActive0()
 		{
+			if (stage == 0 && cycles.count + cycles.one * 255U < cycles.round)
+			{
+				HActiveLine();
+				return;
+			}
+
 			tiles.Load();
 
 			if (io.enabled)
@@ -1484,6 +1609,98 @@ namespace Nes
 			}
 		}
 
+		void Ppu::HActiveLine()
+		{
+			NST_ASSERT( stage == 0 );
+
+			// Nothing can touch the PPU before the round ends, so the
+			// whole visible part of the line is run in one go. Same
+			// sequence of fetches and pixels as HActive0-HActive7.
+
+			uint noSpHitOn255;
+
+			do
+			{
+				tiles.Load();
+
+				if (io.enabled)
+					io.address = scroll.address;
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				if (stage == 8)
+					EvaluateSprites();
+
+				if (io.enabled)
+					io.pattern = FetchName();
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				if (io.enabled)
+					io.address = scroll.address;
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				if (io.enabled)
+				{
+					tiles.attribute = FetchAttribute();
+					scroll.ClockX();
+
+					if (stage == 31)
+						scroll.ClockY();
+				}
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				if (io.enabled)
+				{
+					io.address = io.pattern | 0x0;
+
+					if (io.a12.InUse() && (regs.ctrl0 & Regs::CTRL0_BG_OFFSET))
+						io.a12.Toggle( cycles.count );
+				}
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				if (io.enabled)
+					tiles.pattern[0] = chrMem.FetchPattern( io.address );
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				if (io.enabled)
+					io.address = io.pattern | 0x8;
+
+				RenderPixel();
+				cycles.count += cycles.one;
+
+				noSpHitOn255 = regs.status;
+
+				RenderPixel();
+
+				oam.clip = ~0U;
+				tiles.clip = ~0U;
+
+				if (io.enabled)
+					tiles.pattern[1] = chrMem.FetchPattern( io.address );
+
+				cycles.count += cycles.one;
+
+				stage = (stage + 1) & 31;
+			}
+			while (stage);
+
+			cycles.count += cycles.one;
+			regs.status = noSpHitOn255;
+
+			NST_PPU_NEXT_PHASE( HBlank );
+		}
+
 		void Ppu::HBlank()
 		{
 			NST_ASSERT( stage == 0 );
@@ -1491,7 +1708,12 @@ namespace Nes
 			spHook.Execute();
 
 			oam.loaded = oam.buffer;
-			oam.visible = oam.output;
+
+			if (oam.visible)
+			{
+				oam.visible = 0;
+				std::memset( oam.line, 0, sizeof(oam.line) );
+			}
 
 			if (io.enabled)
 				scroll.ResetX();
@@ -1697,7 +1919,12 @@ namespace Nes
 			regs.status = (regs.status & 0xFF) | (regs.status >> 1 & Regs::STATUS_VBLANK);
 			scanline = SCANLINE_VBLANK;
 			oam.address = 0x00;
-			oam.visible = oam.output;
+
+			if (oam.visible)
+			{
+				oam.visible = 0;
+				std::memset( oam.line, 0, sizeof(oam.line) );
+			}
 
 			if (cycles.spriteOverflow != NES_CYCLE_MAX)
 			{
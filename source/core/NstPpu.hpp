@@ -267,6 +267,7 @@ namespace Nes
 			void HActive5();
 			void HActive6();
 			void HActive7();
+			void HActiveLine();
 			void HBlank();
 			void HBlankSp();
 			void HBlankBg();
@@ -460,29 +461,29 @@ namespace Nes
 					u8 comparitor;
 				};
 
-				struct Output
+				enum
 				{
-					u8 x;
-					u8 behind;
-					u8 zero;
-					u8 palette;
+					LINE_COLOR  = b00001111,
+					LINE_BEHIND = b00110000,
+					LINE_ZERO   = b11000000,
+					LINE_SIZE   = Video::Screen::WIDTH + 8
+				};
 
-					union
-					{
-						u8 pixels[8];
-						u32 block[2];
-					};
+				enum
+				{
+					VISIBLE_SPRITES = b01,
+					VISIBLE_ZERO    = b10
 				};
 
-				Output* visible;
+				uint visible;
 				Buffer* evaluated;
 				const Buffer* loaded;
 				const Buffer* limit;
 				uint show;
 				uint clip;
 
-				Output output[MAX_LINE_SPRITES];
 				Buffer buffer[MAX_LINE_SPRITES];
+				u8 line[LINE_SIZE];
 
 				uint address;
 				u8 ram[SIZE];
@@ -526,12 +527,12 @@ namespace Nes
 			const YuvMap* yuvMap;
 			Video::Screen screen;
 
-			static void LogMsg(cstring,uint,uint);
+			void LogMsg(cstring,uint,uint);
 
 			template<size_t N>
-			static inline void LogMsg(const char (&)[N],uint);
+			inline void LogMsg(const char (&)[N],uint);
 
-			static dword logged;
+			dword logged;
 
 		public:
 
@@ -72,35 +72,49 @@ namespace Nes
 			#pragma optimize("", on)
 			#endif
 
-			void Pcm::Play(const i16* w,dword l,dword r)
+			void Pcm::Play(const i16* w,dword l)
 			{
-				NST_ASSERT( NES_SUCCEEDED(CanDo(w,l,16,r)) );
+				NST_ASSERT( w && l );
 
-				wave.data = w;
-				wave.length = l;
-				wave.rate = r;
+				// already at the output rate, played back one to one
 
-				pos = 0;
-				rate = cpu.GetApu().GetSampleRate();
+				wave.data = w;
+				wave.end = w + l;
 			}
 
 			Pcm::Sample Pcm::GetSample()
 			{
 				if (wave.data)
 				{
-					const uint i = pos / rate;
-
-					if (i < wave.length)
-					{
-						pos += wave.rate;
-						return wave.data[i];
-					}
+					if (wave.data != wave.end)
+						return *wave.data++;
 
 					wave.data = NULL;
 				}
 
 				return 0;
 			}
+
+			Cycle Pcm::Render(Sample* const output,const uint length,Cycle,Cycle,const Cycle next)
+			{
+				uint i = 0;
+
+				if (wave.data)
+				{
+					const uint count = NST_MIN(length,uint(wave.end - wave.data));
+
+					for (; i < count; ++i)
+						output[i] = *wave.data++;
+
+					if (wave.data == wave.end)
+						wave.data = NULL;
+				}
+
+				for (; i < length; ++i)
+					output[i] = 0;
+
+				return next;
+			}
 		}
 	}
 }
@@ -43,7 +43,8 @@ namespace Nes
 				~Pcm();
 
 				void Reset();
-				void Play(const i16*,dword,dword);
+				void Play(const i16*,dword);
+				void UpdateContext(uint,const u8 (&)[MAX_CHANNELS]);
 
 				static Result CanDo(const void*,dword,uint,dword);
 
@@ -51,19 +52,16 @@ namespace Nes
 
 			private:
 
-				void UpdateContext(uint,const u8 (&)[MAX_CHANNELS]);
 				Sample GetSample();
+				Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				struct Wave
 				{
 					const i16* data;
-					dword length;
-					dword rate;
+					const i16* end;
 				};
 
 				Wave wave;
-				qword pos;
-				dword rate;
 
 			public:
 
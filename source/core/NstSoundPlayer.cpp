@@ -41,13 +41,13 @@ namespace Nes
 			class Player::SampleLoader : public Loader
 			{
 				Slots& slots;
+				Arena& source;
 
 				Result Load(uint slot,const void* input,dword length,bool stereo,uint bits,dword rate) throw()
 				{
 					Result result;
-					i16* data;
 
-					if (slot >= slots.size() || slots[slot].data)
+					if (slot >= slots.size() || slots[slot].length)
 					{
 						return RESULT_ERR_INVALID_PARAM;
 					}
@@ -55,15 +55,24 @@ namespace Nes
 					{
 						return result;
 					}
-					else if (NULL == (data = new (std::nothrow) i16 [length]))
+
+					const dword offset = source.size();
+
+					try
+					{
+						source.resize( offset + length );
+					}
+					catch (const std::bad_alloc&)
 					{
 						return RESULT_ERR_OUT_OF_MEMORY;
 					}
 
-					slots[slot].data = data;
+					slots[slot].offset = offset;
 					slots[slot].length = length;
 					slots[slot].rate = rate;
 
+					i16* NST_RESTRICT data = &source[offset];
+
 					if (bits == 8)
 					{
 						const u8* NST_RESTRICT src = static_cast<const u8*>(input);
@@ -108,16 +117,69 @@ namespace Nes
 
 			public:
 
-				SampleLoader(Slots& s)
-				: slots(s) {}
+				SampleLoader(Slots& s,Arena& a)
+				: slots(s), source(a) {}
 			};
 
 			Player::Player(Cpu& c,uint n)
-			: Pcm(c), slots(n)
+			: Pcm(c), slots(n), rate(0)
 			{
 				NST_ASSERT( n );
 			}
 
+			void Player::UpdateContext(uint old,const u8 (&volumes)[Apu::MAX_CHANNELS])
+			{
+				Pcm::UpdateContext( old, volumes );
+
+				if (rate != cpu.GetApu().GetSampleRate())
+					Convert();
+			}
+
+			void Player::Convert()
+			{
+				// Steps through each source the same way playback did per sample
+				// before, only now once up front for the whole set of slots.
+
+				rate = cpu.GetApu().GetSampleRate();
+
+				dword total = 0;
+
+				for (Slots::iterator it(slots.begin()), end(slots.end()); it != end; ++it)
+				{
+					it->start = total;
+					it->count = it->length ? (qword(it->length) * rate + it->rate - 1) / it->rate : 0;
+					total += it->count;
+				}
+
+				try
+				{
+					output.resize( total );
+				}
+				catch (const std::bad_alloc&)
+				{
+					Arena().swap( output );
+
+					for (Slots::iterator it(slots.begin()), end(slots.end()); it != end; ++it)
+						it->count = 0;
+
+					return;
+				}
+
+				for (Slots::const_iterator it(slots.begin()), end(slots.end()); it != end; ++it)
+				{
+					if (it->count)
+					{
+						const i16* const NST_RESTRICT src = &source[it->offset];
+						i16* const NST_RESTRICT dst = &output[it->start];
+
+						qword pos = 0;
+
+						for (dword i=0; i < it->count; ++i, pos += it->rate)
+							dst[i] = src[pos / rate];
+					}
+				}
+			}
+
 			Player* Player::Create(Cpu& cpu,Loader::Type type,uint samples)
 			{
 				if (samples)
@@ -125,14 +187,17 @@ namespace Nes
 					if (Player* const player = new (std::nothrow) Player(cpu,samples))
 					{
 						{
-							SampleLoader loader( player->slots );
+							SampleLoader loader( player->slots, player->source );
 							Loader::loadCallback( type, loader );
 						}
 
 						while (samples--)
 						{
-							if (player->slots[samples].data)
+							if (player->slots[samples].length)
+							{
+								player->Convert();
 								return player;
+							}
 						}
 
 						delete player;
@@ -54,31 +54,38 @@ namespace Nes
 
 				Player(Cpu&,uint);
 
+				void UpdateContext(uint,const u8 (&)[Apu::MAX_CHANNELS]);
+				void Convert();
+
+				// source and converted samples each live in one shared arena,
+				// the slots hold offsets into them rather than pointers
+
 				struct Slot
 				{
-					const i16* data;
+					dword offset;
 					dword length;
 					dword rate;
+					dword start;
+					dword count;
 
 					Slot()
-					: data(NULL) {}
-
-					~Slot()
-					{
-						delete [] data;
-					}
+					: length(0), count(0) {}
 				};
 
 				typedef std::vector<Slot> Slots;
+				typedef std::vector<i16> Arena;
 
 				Slots slots;
+				Arena source;
+				Arena output;
+				dword rate;
 
 			public:
 
 				void Play(uint i)
 				{
-					if (i < slots.size() && slots[i].data)
-						Pcm::Play( slots[i].data, slots[i].length, slots[i].rate );
+					if (i < slots.size() && slots[i].count)
+						Pcm::Play( &output[slots[i].start], slots[i].count );
 				}
 			};
 		}
@@ -23,9 +23,19 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include "NstCore.hpp"
+#include "NstSignedArithmetic.hpp"
 #include "NstCpu.hpp"
 #include "NstSoundRenderer.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NST_SOUND_SSE2
+#include <emmintrin.h>
+#ifdef __AVX2__
+#define NST_SOUND_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 namespace Nes
 {
 	namespace Core
@@ -38,6 +48,7 @@ namespace Nes
 
 			Buffer::Buffer(uint bits)
 			{
+				resampler.target = Resampler::ONE;
 				Reset( bits, true );
 			}
 
@@ -46,7 +57,7 @@ namespace Nes
 				pos = start = 0;
 				history.pos = 0;
 
-				bits = (bits == 16 ? 0 : 0x80);
+				bits = (bits == 8 ? 0x80 : 0);
 
 				for (uint i=0; i < History::SIZE; ++i)
 					history.buffer[i] = bits;
@@ -56,12 +67,160 @@ namespace Nes
 					for (uint i=0; i < SIZE; ++i)
 						output[i] = 0;
 				}
+
+				resampler.Reset();
+			}
+
+			void Buffer::Resampler::Reset()
+			{
+				// the window starts out on silence with the read position three
+				// samples short of its end, right where the first new one lands
+
+				step = target;
+				phase = ONE * 3;
+
+				for (uint i=0; i < 4; ++i)
+					window[i] = 0;
+			}
+
+			void Buffer::Resampler::Adjust(const idword ppm)
+			{
+				target = qword(ONE) * 1000000UL / dword(1000000L + ppm);
+			}
+
+			void Buffer::Resampler::Update()
+			{
+				// glide an eighth of the way per frame, small enough
+				// steps for the pitch to never audibly jump
+
+				step = idword(target) + (idword(step) - idword(target)) * 7 / 8;
+			}
+
+			void Buffer::SetRateAdjustment(const idword ppm)
+			{
+				resampler.Adjust( ppm );
+			}
+
+			void Buffer::UpdateRate()
+			{
+				resampler.Update();
+			}
+
+			uint Buffer::ResampledLatency() const
+			{
+				// number of samples Resample() will produce from what's queued
+
+				const qword end = qword(Latency() + 1) << Resampler::SHIFT;
+
+				return end > resampler.phase ? uint((end - resampler.phase + resampler.step - 1) / resampler.step) : 0;
+			}
+
+			uint Buffer::ResamplerDemand(const uint length) const
+			{
+				// number of queued samples Resample() needs to produce length
+
+				return length ? uint((resampler.phase + qword(length - 1) * resampler.step) >> Resampler::SHIFT) : 0;
 			}
 
 			#ifdef NST_PRAGMA_OPTIMIZE
 			#pragma optimize("", on)
 			#endif
 
+			void Buffer::Convert(float* NST_RESTRICT dst,const i16* NST_RESTRICT src,uint length)
+			{
+				#if defined(NST_SOUND_AVX2)
+
+				const __m256 scale = _mm256_set1_ps( 1.f / 32768 );
+
+				for (; length >= 8; length -= 8, src += 8, dst += 8)
+				{
+					const __m256i x = _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(src) ) );
+					_mm256_storeu_ps( dst, _mm256_mul_ps( _mm256_cvtepi32_ps( x ), scale ) );
+				}
+
+				#elif defined(NST_SOUND_SSE2)
+
+				const __m128 scale = _mm_set1_ps( 1.f / 32768 );
+
+				for (; length >= 8; length -= 8, src += 8, dst += 8)
+				{
+					// sign-extend by unpacking into the upper halves and shifting down
+
+					const __m128i x = _mm_loadu_si128( reinterpret_cast<const __m128i*>(src) );
+					_mm_storeu_ps( dst+0, _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( x, x ), 16 ) ), scale ) );
+					_mm_storeu_ps( dst+4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( x, x ), 16 ) ), scale ) );
+				}
+
+				#endif
+
+				for (; length; --length)
+					*dst++ = float(*src++) * (1.f / 32768);
+			}
+
+			void Buffer::Convert(float* NST_RESTRICT dst,const i16* NST_RESTRICT left,const i16* NST_RESTRICT right,uint length)
+			{
+				#ifdef NST_SOUND_SSE2
+
+				const __m128 scale = _mm_set1_ps( 1.f / 32768 );
+
+				for (; length >= 8; length -= 8, left += 8, right += 8, dst += 16)
+				{
+					const __m128i l = _mm_loadu_si128( reinterpret_cast<const __m128i*>(left) );
+					const __m128i r = _mm_loadu_si128( reinterpret_cast<const __m128i*>(right) );
+
+					const __m128 l0 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( l, l ), 16 ) ), scale );
+					const __m128 l1 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( l, l ), 16 ) ), scale );
+					const __m128 r0 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( r, r ), 16 ) ), scale );
+					const __m128 r1 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( r, r ), 16 ) ), scale );
+
+					_mm_storeu_ps( dst+0,  _mm_unpacklo_ps( l0, r0 ) );
+					_mm_storeu_ps( dst+4,  _mm_unpackhi_ps( l0, r0 ) );
+					_mm_storeu_ps( dst+8,  _mm_unpacklo_ps( l1, r1 ) );
+					_mm_storeu_ps( dst+12, _mm_unpackhi_ps( l1, r1 ) );
+				}
+
+				#endif
+
+				for (; length; --length, dst += 2)
+				{
+					dst[0] = float(*left++) * (1.f / 32768);
+					dst[1] = float(*right++) * (1.f / 32768);
+				}
+			}
+
+			bool Buffer::Renderer<float,1U>::operator << (const Block& block)
+			{
+				NST_ASSERT( uint(end - dst) >= block.length * 2 );
+
+				// The left side lags History::SIZE samples behind. Only the first
+				// ones need the history, the rest can be taken from the block.
+
+				const uint head = NST_MIN(block.length,uint(History::SIZE));
+
+				for (uint i=0; i < head; ++i)
+					(*this) << (Apu::Sample) block.data[(block.start + i) & MASK];
+
+				for (uint i=head; i < block.length; )
+				{
+					const uint right = (block.start + i) & MASK;
+					const uint left = (right - History::SIZE) & MASK;
+					const uint length = NST_MIN(block.length - i,SIZE - NST_MAX(left,right));
+
+					Convert( dst, block.data + left, block.data + right, length );
+
+					dst += length * 2;
+					i += length;
+				}
+
+				if (block.length > head)
+				{
+					for (uint i=block.length - History::SIZE; i < block.length; ++i)
+						history << block.data[(block.start + i) & MASK];
+				}
+
+				return dst != end;
+			}
+
 			void Buffer::operator >> (Block& block)
 			{
 				NST_ASSERT( block.length );
@@ -79,6 +238,145 @@ namespace Nes
 				if (start == pos)
 					start = pos = 0;
 			}
+
+			// windowed sinc impulses, one row per sub-sample phase,
+			// each adding up to exactly one unit so that steps settle
+
+			const i16 StepBuffer::kernel[PHASES][TAPS] =
+			{
+				{1,-6,8,23,-150,492,-1342,5069,5071,-1342,492,-150,23,8,-6,1},
+				{1,-6,6,28,-161,508,-1353,4942,5198,-1328,475,-139,16,11,-7,1},
+				{1,-5,4,34,-171,522,-1360,4811,5321,-1311,457,-127,10,13,-8,1},
+				{1,-4,1,39,-181,534,-1365,4678,5444,-1291,438,-114,4,16,-9,1},
+				{1,-4,-1,45,-190,545,-1367,4543,5564,-1268,417,-101,-3,19,-9,1},
+				{0,-3,-3,50,-199,555,-1366,4407,5683,-1241,394,-87,-10,21,-10,1},
+				{0,-2,-5,54,-206,564,-1362,4270,5794,-1211,371,-73,-17,24,-11,2},
+				{0,-2,-7,59,-214,571,-1355,4132,5905,-1178,346,-58,-24,27,-12,2},
+				{0,-1,-9,63,-220,577,-1346,3992,6013,-1141,319,-43,-31,30,-13,2},
+				{0,-1,-11,67,-226,581,-1335,3852,6118,-1101,292,-27,-39,33,-13,2},
+				{0,0,-12,70,-232,585,-1321,3711,6220,-1058,263,-11,-46,35,-14,2},
+				{0,0,-14,74,-236,586,-1305,3570,6318,-1011,233,6,-54,38,-15,2},
+				{0,1,-16,77,-240,587,-1286,3428,6412,-960,202,22,-62,41,-16,2},
+				{0,1,-17,80,-244,587,-1265,3286,6502,-906,169,40,-70,44,-17,2},
+				{0,1,-18,82,-247,585,-1243,3144,6588,-848,136,57,-78,47,-17,3},
+				{0,2,-20,85,-249,582,-1218,3002,6670,-787,101,75,-86,50,-18,3},
+				{0,2,-21,87,-251,578,-1191,2861,6748,-723,66,93,-94,53,-19,3},
+				{0,2,-22,89,-252,573,-1163,2720,6822,-655,29,112,-102,56,-20,3},
+				{0,3,-23,90,-253,566,-1133,2579,6893,-583,-8,130,-110,58,-20,3},
+				{0,3,-24,92,-253,559,-1101,2440,6958,-509,-47,149,-118,61,-21,3},
+				{0,3,-24,93,-252,551,-1068,2301,7017,-430,-86,168,-126,64,-22,3},
+				{0,3,-25,94,-251,542,-1034,2163,7074,-349,-126,187,-134,67,-23,4},
+				{0,4,-26,95,-250,532,-998,2027,7123,-264,-166,206,-141,69,-23,4},
+				{0,4,-26,95,-248,521,-961,1891,7170,-175,-207,225,-149,72,-24,4},
+				{0,4,-27,95,-245,509,-923,1758,7213,-84,-249,244,-157,74,-24,4},
+				{0,4,-27,95,-242,496,-884,1626,7249,11,-291,263,-164,77,-25,4},
+				{0,4,-27,95,-239,483,-844,1495,7283,108,-334,282,-172,79,-25,4},
+				{0,4,-27,95,-235,469,-804,1367,7310,209,-377,301,-179,81,-26,4},
+				{0,4,-28,94,-231,454,-763,1240,7335,313,-420,319,-186,83,-26,4},
+				{0,4,-28,93,-227,439,-721,1116,7352,420,-463,337,-192,85,-27,4},
+				{0,4,-28,92,-222,423,-679,994,7365,529,-506,355,-199,87,-27,4},
+				{0,4,-28,91,-216,407,-636,874,7372,641,-550,373,-205,88,-27,4},
+				{0,4,-27,90,-211,390,-593,756,7374,756,-593,390,-211,90,-27,4},
+				{0,4,-27,88,-205,373,-550,641,7372,874,-636,407,-216,91,-28,4},
+				{0,4,-27,87,-199,355,-506,529,7365,994,-679,423,-222,92,-28,4},
+				{0,4,-27,85,-192,337,-463,420,7352,1116,-721,439,-227,93,-28,4},
+				{0,4,-26,83,-186,319,-420,313,7335,1240,-763,454,-231,94,-28,4},
+				{0,4,-26,81,-179,301,-377,209,7310,1367,-804,469,-235,95,-27,4},
+				{0,4,-25,79,-172,282,-334,108,7283,1495,-844,483,-239,95,-27,4},
+				{0,4,-25,77,-164,263,-291,11,7249,1626,-884,496,-242,95,-27,4},
+				{0,4,-24,74,-157,244,-249,-84,7213,1758,-923,509,-245,95,-27,4},
+				{0,4,-24,72,-149,225,-207,-175,7170,1891,-961,521,-248,95,-26,4},
+				{0,4,-23,69,-141,206,-166,-264,7123,2027,-998,532,-250,95,-26,4},
+				{0,4,-23,67,-134,187,-126,-349,7074,2163,-1034,542,-251,94,-25,3},
+				{0,3,-22,64,-126,168,-86,-430,7017,2301,-1068,551,-252,93,-24,3},
+				{0,3,-21,61,-118,149,-47,-509,6958,2440,-1101,559,-253,92,-24,3},
+				{0,3,-20,58,-110,130,-8,-583,6892,2579,-1133,567,-253,90,-23,3},
+				{0,3,-20,56,-102,112,29,-655,6822,2720,-1163,573,-252,89,-22,2},
+				{0,3,-19,53,-94,93,66,-723,6748,2861,-1191,578,-251,87,-21,2},
+				{0,3,-18,50,-86,75,101,-787,6669,3003,-1218,582,-249,85,-20,2},
+				{0,3,-17,47,-78,57,136,-848,6588,3144,-1243,585,-247,82,-18,1},
+				{0,2,-17,44,-70,40,169,-906,6502,3286,-1265,587,-244,80,-17,1},
+				{0,2,-16,41,-62,22,202,-960,6412,3428,-1286,587,-240,77,-16,1},
+				{0,2,-15,38,-54,6,233,-1011,6318,3570,-1305,586,-236,74,-14,0},
+				{-1,2,-14,35,-46,-11,263,-1058,6220,3712,-1321,585,-232,70,-12,0},
+				{-1,2,-13,33,-39,-27,292,-1101,6118,3853,-1335,581,-226,67,-11,-1},
+				{-1,2,-13,30,-31,-43,319,-1142,6015,3993,-1347,577,-220,63,-9,-1},
+				{-1,2,-12,27,-24,-58,346,-1178,5907,4132,-1356,571,-214,59,-7,-2},
+				{-1,2,-11,24,-17,-73,371,-1212,5795,4271,-1362,564,-206,54,-5,-2},
+				{-1,1,-10,21,-10,-87,394,-1242,5684,4408,-1366,555,-199,50,-3,-3},
+				{-1,1,-9,19,-3,-101,417,-1268,5564,4544,-1367,546,-190,45,-1,-4},
+				{-1,1,-9,16,4,-114,438,-1292,5446,4679,-1365,534,-181,39,1,-4},
+				{-1,1,-8,13,10,-127,457,-1312,5324,4812,-1361,522,-171,34,4,-5},
+				{-1,1,-7,11,16,-139,475,-1329,5200,4943,-1353,508,-161,28,6,-6}
+			};
+
+			#ifdef NST_PRAGMA_OPTIMIZE
+			#pragma optimize("s", on)
+			#endif
+
+			StepBuffer::StepBuffer()
+			: factor(0)
+			{
+				Reset();
+			}
+
+			bool StepBuffer::SetRate(const qword samples,const qword clocks,const Cycle frame)
+			{
+				NST_ASSERT( clocks );
+
+				const qword f( (samples << FRAC_BITS) / clocks );
+
+				if (dword((qword(frame) * f) >> FRAC_BITS) + TAPS >= SIZE)
+					return false;
+
+				factor = f;
+				Reset();
+
+				return true;
+			}
+
+			void StepBuffer::Reset()
+			{
+				offset = 0;
+				level = 0;
+				std::memset( buffer, 0, sizeof(buffer) );
+			}
+
+			#ifdef NST_PRAGMA_OPTIMIZE
+			#pragma optimize("", on)
+			#endif
+
+			uint StepBuffer::EndFrame(const Cycle clock)
+			{
+				// integrate the steps of every sample that no
+				// longer can be touched and leave them in place
+
+				const qword pos( qword(clock) * factor + offset );
+
+				uint count = dword(pos >> FRAC_BITS);
+				offset = dword(pos);
+
+				NST_VERIFY( count <= SIZE );
+
+				if (count > SIZE)
+					count = SIZE;
+
+				for (uint i=0; i < count; ++i)
+				{
+					level += buffer[i];
+					buffer[i] = sign_shr( level, UNIT_BITS );
+				}
+
+				return count;
+			}
+
+			void StepBuffer::Remove(const uint count)
+			{
+				NST_ASSERT( count <= SIZE );
+
+				std::memmove( buffer, buffer + count, sizeof(idword) * (SIZE+TAPS-count) );
+				std::memset( buffer + (SIZE+TAPS-count), 0, sizeof(idword) * count );
+			}
 		}
 	}
 }
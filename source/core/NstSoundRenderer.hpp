@@ -30,6 +30,7 @@
 #endif
 
 #include <cstring>
+#include "NstSignedArithmetic.hpp"
 #include "api/NstApiSound.hpp"
 
 namespace Nes
@@ -63,9 +64,47 @@ namespace Nes
 				void Reset(uint,bool=true);
 				void operator >> (Block&);
 
+				void SetRateAdjustment(idword);
+				void UpdateRate();
+				uint ResampledLatency() const;
+				uint ResamplerDemand(uint) const;
+
+				template<typename T>
+				bool Resample(T&);
+
+				static void Convert(float*,const i16*,uint);
+				static void Convert(float*,const i16*,const i16*,uint);
+
 				template<typename,uint>
 				class Renderer;
 
+				class Writer
+				{
+					Buffer& buffer;
+					uint length;
+
+				public:
+
+					Writer(Buffer& b,uint l)
+					: buffer(b), length(l) {}
+
+					operator bool () const
+					{
+						return length;
+					}
+
+					uint Length() const
+					{
+						return length;
+					}
+
+					void operator << (Apu::Sample sample)
+					{
+						buffer << sample;
+						--length;
+					}
+				};
+
 			private:
 
 				template<typename T>
@@ -75,11 +114,13 @@ namespace Nes
 
 					T* NST_RESTRICT dst;
 					const T* const end;
+					const uint stereo;
 
 					BaseRenderer(void* samples,uint length,bool stereo=false)
 					:
-					dst (static_cast<T*>(samples)),
-					end (static_cast<const T*>(samples) + (length << (uint) stereo))
+					dst    (static_cast<T*>(samples)),
+					end    (static_cast<const T*>(samples) + (length << (uint) stereo)),
+					stereo (stereo)
 					{}
 
 				public:
@@ -88,6 +129,11 @@ namespace Nes
 					{
 						return dst != end;
 					}
+
+					uint Length() const
+					{
+						return uint(end - dst) >> stereo;
+					}
 				};
 
 				struct History
@@ -113,9 +159,53 @@ namespace Nes
 					}
 				};
 
+				class Resampler
+				{
+				public:
+
+					enum
+					{
+						SHIFT = 20,
+						ONE = 1UL << SHIFT
+					};
+
+					void Reset();
+					void Adjust(idword);
+					void Update();
+
+					// four-point Catmull-Rom between window[1] and window[2],
+					// the position kept to 11 bits so the products fit in 32
+
+					Apu::Sample Interpolate() const
+					{
+						const idword t = phase >> (SHIFT-11);
+
+						idword v = (window[3] - window[0]) + 3 * (window[1] - window[2]);
+						v = sign_shr( v * t, 11 ) + (2 * window[0] - 5 * window[1] + 4 * window[2] - window[3]);
+						v = sign_shr( v * t, 11 ) + (window[2] - window[0]);
+						v = window[1] + sign_shr( v * t, 12 );
+
+						return (v <= 32767L) ? (v >= -32768L) ? v : -32768L : 32767L;
+					}
+
+					void Push(idword sample)
+					{
+						window[0] = window[1];
+						window[1] = window[2];
+						window[2] = window[3];
+						window[3] = sample;
+					}
+
+					dword step;
+					dword target;
+					dword phase;
+					idword window[4];
+				};
+
 				i16 output[SIZE];
 				uint pos;
 				uint start;
+				Resampler resampler;
 
 			public:
 
@@ -259,6 +349,159 @@ namespace Nes
 					return dst != end;
 				}
 			};
+
+			template<>
+			class Buffer::Renderer<float,0U> : public Buffer::BaseRenderer<float>
+			{
+			public:
+
+				Renderer(void* samples,uint length)
+				: BaseRenderer<float>(samples,length) {}
+
+				NST_FORCE_INLINE void operator << (Apu::Sample sample)
+				{
+					*dst++ = float(sample) * (1.f / 32768);
+				}
+
+				NST_FORCE_INLINE bool operator << (const Block& block)
+				{
+					NST_ASSERT( uint(end - dst) >= block.length );
+
+					if (block.length)
+					{
+						if (block.start + block.length <= SIZE)
+						{
+							Convert( dst, block.data + block.start, block.length );
+						}
+						else
+						{
+							const uint chunk = SIZE - block.start;
+							Convert( dst, block.data + block.start, chunk );
+							Convert( dst + chunk, block.data, (block.start + block.length) - SIZE );
+						}
+
+						dst += block.length;
+					}
+
+					return dst != end;
+				}
+			};
+
+			template<>
+			class Buffer::Renderer<float,1U> : public Buffer::BaseRenderer<float>
+			{
+				History& history;
+
+			public:
+
+				Renderer(void* samples,uint length,History& h)
+				: BaseRenderer<float>(samples,length,true), history(h) {}
+
+				NST_FORCE_INLINE void operator << (Apu::Sample sample)
+				{
+					i16 prev;
+					history >> prev;
+					history << sample;
+					dst[0] = float(prev) * (1.f / 32768);
+					dst[1] = float(sample) * (1.f / 32768);
+					dst += 2;
+				}
+
+				bool operator << (const Block&);
+			};
+
+			template<typename T>
+			bool Buffer::Resample(T& renderer)
+			{
+				// Consumes samples only as the read position passes them, what's
+				// left over stays queued for the next frame. Returns false once
+				// the renderer is full and true if it ran out of samples first.
+
+				while (renderer)
+				{
+					for (; resampler.phase >= Resampler::ONE; resampler.phase -= Resampler::ONE)
+					{
+						if (start == pos)
+						{
+							start = pos = 0;
+							return true;
+						}
+
+						resampler.Push( output[start] );
+						start = (start + 1) & MASK;
+					}
+
+					renderer << resampler.Interpolate();
+					resampler.phase += resampler.step;
+				}
+
+				if (start == pos)
+					start = pos = 0;
+
+				return false;
+			}
+
+			class StepBuffer
+			{
+			public:
+
+				StepBuffer();
+
+				enum
+				{
+					SIZE = 0x4000U,
+					TAPS = 16,
+					UNIT_BITS = 13
+				};
+
+				bool SetRate(qword,qword,Cycle);
+				void Reset();
+				uint EndFrame(Cycle);
+				void Remove(uint);
+
+			private:
+
+				enum
+				{
+					FRAC_BITS = 32,
+					PHASE_BITS = 6,
+					PHASES = 1U << PHASE_BITS
+				};
+
+				qword factor;
+				qword offset;
+				idword level;
+				idword buffer[SIZE+TAPS];
+
+				static const i16 kernel[PHASES][TAPS];
+
+			public:
+
+				NST_FORCE_INLINE void Add(const Cycle clock,const idword delta)
+				{
+					// spread the step over the taps of the band-limited
+					// impulse closest to where it falls between samples
+
+					const qword pos( qword(clock) * factor + offset );
+
+					uint index = dword(pos >> FRAC_BITS);
+					NST_VERIFY( index <= SIZE );
+
+					if (index > SIZE)
+						index = SIZE;
+
+					const i16* const NST_RESTRICT src = kernel[dword(pos >> (FRAC_BITS-PHASE_BITS)) & (PHASES-1)];
+					idword* const NST_RESTRICT dst = buffer + index;
+
+					for (uint i=0; i < TAPS; ++i)
+						dst[i] += delta * src[i];
+				}
+
+				idword operator [] (uint i) const
+				{
+					return buffer[i];
+				}
+			};
 		}
 	}
 }
@@ -23,6 +23,7 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include <cstdlib>
+#include <cstring>
 #include "NstCore.hpp"
 
 #ifndef NST_NO_ZLIB
@@ -51,11 +52,86 @@ namespace Nes
 			#pragma optimize("s", on)
 			#endif
 
-			Saver::Saver(StdStream p,bool c,bool i)
-			: stream(p), chunks(CHUNK_RESERVE), useCompression(c), internal(i)
+			Saver::Saver(StdStream p,uint c,bool i)
+			:
+			stream         (p),
+			memory         (NULL),
+			capacity       (0),
+			pos            (0),
+			chunks         (CHUNK_RESERVE),
+			compression    (c),
+			internal       (i),
+			base           (NULL),
+			baseLength     (0),
+			capture        (NULL),
+			image          (NULL)
+			{
+				NST_ASSERT( stream );
+
+				chunks.SetTo(1);
+				chunks[0] = 0;
+			}
+
+			Saver::Saver(void* m,dword n,uint c,bool i)
+			:
+			stream         (NULL),
+			memory         (static_cast<u8*>(m)),
+			capacity       (m ? n : 0),
+			pos            (0),
+			chunks         (CHUNK_RESERVE),
+			compression    (c),
+			internal       (i),
+			base           (NULL),
+			baseLength     (0),
+			capture        (NULL),
+			image          (NULL)
+			{
+				chunks.SetTo(1);
+				chunks[0] = 0;
+			}
+
+			Saver::Saver(void* m,dword n,const void* b,dword l,bool i)
+			:
+			stream         (NULL),
+			memory         (static_cast<u8*>(m)),
+			capacity       (m ? n : 0),
+			pos            (0),
+			chunks         (CHUNK_RESERVE),
+			compression    (COMPRESSION_NONE),
+			internal       (i),
+			base           (static_cast<const u8*>(b)),
+			baseLength     (l),
+			capture        (NULL),
+			image          (&scratch)
+			{
+				NST_ASSERT( base );
+
+				chunks.SetTo(1);
+				chunks[0] = 0;
+
+				scratch.Reserve( l );
+			}
+
+			Saver::Saver(Capture& c,bool i)
+			:
+			stream         (NULL),
+			memory         (NULL),
+			capacity       (0),
+			pos            (0),
+			chunks         (CHUNK_RESERVE),
+			compression    (COMPRESSION_NONE),
+			internal       (i),
+			base           (NULL),
+			baseLength     (0),
+			capture        (&c),
+			image          (&c.image)
 			{
 				chunks.SetTo(1);
 				chunks[0] = 0;
+
+				c.image.Clear();
+				c.marks.Clear();
+				c.internal = i;
 			}
 
 			Saver::~Saver()
@@ -67,11 +143,131 @@ namespace Nes
 			#pragma optimize("", on)
 			#endif
 
+			dword Saver::GetPos() const
+			{
+				return stream ? Stream::Out(stream).GetPos() : pos;
+			}
+
+			void Saver::Put32(u8* const dst,const dword data)
+			{
+				dst[0] = data & 0xFF;
+				dst[1] = data >>  8 & 0xFF;
+				dst[2] = data >> 16 & 0xFF;
+				dst[3] = data >> 24;
+			}
+
+			dword Saver::Get32(const u8* const src)
+			{
+				return src[0] | dword(src[1]) << 8 | dword(src[2]) << 16 | dword(src[3]) << 24;
+			}
+
+			void Saver::Store(const dword at,const u8* const data,const dword length)
+			{
+				if (image)
+				{
+					if (image->Size() < at + length)
+					{
+						if (image->Capacity() < at + length)
+							image->Reserve( (at + length) * 2 );
+
+						image->SetTo( at + length );
+					}
+
+					std::memcpy( image->Begin() + at, data, length );
+				}
+				else if (at <= capacity && length <= capacity - at)
+				{
+					std::memcpy( memory + at, data, length );
+				}
+			}
+
+			dword Saver::Diff()
+			{
+				NST_ASSERT( base && chunks.Size() == 1 );
+
+				// compared page by page against the base, where
+				// anything past its end counts as zeros
+
+				const u8* const src = scratch.Begin();
+				dword length = 4;
+
+				if (capacity >= 4)
+					Put32( memory, pos );
+
+				for (dword start=0; start < pos; start += PAGE_SIZE)
+				{
+					const dword count = NST_MIN(dword(PAGE_SIZE),pos - start);
+					const dword common = (start < baseLength ? NST_MIN(count,baseLength - start) : 0);
+
+					bool dirty = (common && std::memcmp( src + start, base + start, common ));
+
+					for (dword i=common; !dirty && i < count; ++i)
+						dirty = src[start+i];
+
+					if (dirty)
+					{
+						if (length <= capacity && PAGE_RECORD <= capacity - length)
+						{
+							u8* const dst = memory + length;
+
+							Put32( dst, start / PAGE_SIZE );
+							std::memcpy( dst + 4, src + start, count );
+							std::memset( dst + 4 + count, 0x00, PAGE_SIZE - count );
+						}
+
+						length += PAGE_RECORD;
+					}
+				}
+
+				return length;
+			}
+
+			dword Saver::Materialize(const void* const b,const dword baseLength,const void* const d,const dword deltaLength,void* const m,const dword capacity)
+			{
+				const u8* const base = static_cast<const u8*>(b);
+				const u8* const delta = static_cast<const u8*>(d);
+				u8* const memory = static_cast<u8*>(m);
+
+				if (deltaLength < 4 || (deltaLength - 4) % PAGE_RECORD)
+					throw RESULT_ERR_CORRUPT_FILE;
+
+				const dword length = Get32( delta );
+
+				if (memory && length <= capacity)
+				{
+					// base and target may be one and the same
+
+					const dword common = NST_MIN(length,baseLength);
+
+					std::memmove( memory, base, common );
+					std::memset( memory + common, 0x00, length - common );
+
+					for (const u8 *it = delta + 4, *const end = delta + deltaLength; it != end; it += PAGE_RECORD)
+					{
+						const dword page = Get32( it );
+
+						if (page >= (length + PAGE_SIZE-1) / PAGE_SIZE)
+							throw RESULT_ERR_CORRUPT_FILE;
+
+						const dword start = page * PAGE_SIZE;
+						std::memcpy( memory + start, it + 4, NST_MIN(dword(PAGE_SIZE),length - start) );
+					}
+				}
+
+				return length;
+			}
+
 			Saver& Saver::Begin(dword id)
 			{
-				stream.Write32( id );
-				chunks << stream.GetPos();
-				stream.Write32( 0 );
+				if (capture)
+				{
+					const Capture::Mark mark = {Capture::MARK_BEGIN,pos,0};
+					capture->marks << mark;
+				}
+
+				Write32( id );
+				chunks << GetPos();
+				Write32( 0 );
 
 				return *this;
 			}
@@ -81,36 +277,71 @@ namespace Nes
 				NST_VERIFY( chunks.Back() );
 
 				const dword offset = chunks.Pop();
-				const dword pos = stream.GetPos();
 
-				stream.SetPos( offset );
-				stream.Write32( pos - (offset + 4) );
-				stream.SetPos( pos );
+				if (capture)
+				{
+					const Capture::Mark mark = {Capture::MARK_END,pos,0};
+					capture->marks << mark;
+				}
+
+				if (stream)
+				{
+					Stream::Out out( stream );
+					const dword current = out.GetPos();
+
+					out.SetPos( offset );
+					out.Write32( current - (offset + 4) );
+					out.SetPos( current );
+				}
+				else
+				{
+					// patched in place, no seeking back and forth
+
+					u8 length[4];
+					Put32( length, pos - (offset + 4) );
+					Store( offset, length, 4 );
+				}
 
 				return *this;
 			}
 
 			Saver& Saver::Write8(uint data)
 			{
-				stream.Write8( data );
-				return *this;
+				const u8 d = data;
+				return Write( &d, 1 );
 			}
 
 			Saver& Saver::Write16(uint data)
 			{
-				stream.Write16( data );
-				return *this;
+				const u8 d[2] =
+				{
+					u8(data & 0xFF),
+					u8(data >> 8)
+				};
+
+				return Write( d, 2 );
 			}
 
 			Saver& Saver::Write32(dword data)
 			{
-				stream.Write32( data );
-				return *this;
+				u8 d[4];
+				Put32( d, data );
+
+				return Write( d, 4 );
 			}
 
 			Saver& Saver::Write(const void* data,dword length)
 			{
-				stream.Write( data, length );
+				if (stream)
+				{
+					Stream::Out(stream).Write( data, length );
+				}
+				else
+				{
+					Store( pos, static_cast<const u8*>(data), length );
+					pos += length;
+				}
+
 				return *this;
 			}
 
@@ -118,25 +349,30 @@ namespace Nes
 			{
 				NST_VERIFY( length );
 
-              #ifndef NST_NO_ZLIB
+				if (capture)
+				{
+					// left for Capture::Save() to compress
 
-				if (useCompression && length > 1)
+					const Capture::Mark mark = {Capture::MARK_BLOCK,pos,length};
+					capture->marks << mark;
+				}
+              #ifndef NST_NO_ZLIB
+				else if (compression != COMPRESSION_NONE && length > 1)
 				{
-					ulong compression = length - 1;
-					Vector<u8> buffer( compression );
+					ulong packed = length - 1;
+					Vector<u8> buffer( packed );
 
-					if (compress2( buffer.Begin(), &compression, data, length, Z_BEST_COMPRESSION ) == Z_OK && compression)
+					if (compress2( buffer.Begin(), &packed, data, length, compression == COMPRESSION_FAST ? Z_BEST_SPEED : Z_BEST_COMPRESSION ) == Z_OK && packed)
 					{
-						stream.Write8( ZLIB_COMPRESSION );
-						stream.Write( buffer.Begin(), compression );
+						Write8( ZLIB_COMPRESSION );
+						Write( buffer.Begin(), packed );
 						return *this;
 					}
 				}
-
               #endif
 
-				stream.Write8( NO_COMPRESSION );
-				stream.Write( data, length );
+				Write8( NO_COMPRESSION );
+				Write( data, length );
 
 				return *this;
 			}
@@ -145,8 +381,58 @@ namespace Nes
 			#pragma optimize("s", on)
 			#endif
 
+			Capture::Capture()
+			: internal(false) {}
+
+			void Capture::Save(StdStream stream,uint compression) const
+			{
+				// played back through a regular saver, so the outcome
+				// is the same as if the state had been saved directly
+
+				Saver saver( stream, compression, internal );
+
+				const u8* const data = image.Begin();
+				dword pos = 0;
+
+				for (const Mark *it=marks.Begin(), *const end=marks.End(); it != end; ++it)
+				{
+					if (pos < it->pos)
+						saver.Write( data + pos, it->pos - pos );
+
+					switch (it->type)
+					{
+						case MARK_BEGIN:
+
+							saver.Begin( Saver::Get32( data + it->pos ) );
+							pos = it->pos + 8;
+							break;
+
+						case MARK_END:
+
+							saver.End();
+							pos = it->pos;
+							break;
+
+						default:
+
+							saver.Compress( data + it->pos + 1, it->length );
+							pos = it->pos + 1 + it->length;
+							break;
+					}
+				}
+
+				if (pos < image.Size())
+					saver.Write( data + pos, image.Size() - pos );
+			}
+
 			Loader::Loader(StdStream p)
-			: stream(p)
+			: stream(p), memory(NULL), size(0), pos(0)
+			{
+				NST_ASSERT( stream );
+			}
+
+			Loader::Loader(const void* m,dword n)
+			: stream(NULL), memory(static_cast<const u8*>(m)), size(m ? n : 0), pos(0)
 			{
 			}
 
@@ -168,15 +454,58 @@ namespace Nes
 				lengths.Pop();
 			}
 
+			dword Loader::GetPos() const
+			{
+				return stream ? Stream::In(stream).GetPos() : pos;
+			}
+
+			void Loader::SetPos(const dword offset)
+			{
+				if (stream)
+				{
+					Stream::In(stream).SetPos( offset );
+				}
+				else
+				{
+					if (offset > size)
+						throw RESULT_ERR_CORRUPT_FILE;
+
+					pos = offset;
+				}
+			}
+
+			void Loader::Fetch(void* const data,const dword length)
+			{
+				if (stream)
+				{
+					Stream::In(stream).Read( data, length );
+				}
+				else
+				{
+					if (pos > size || length > size - pos)
+						throw RESULT_ERR_CORRUPT_FILE;
+
+					std::memcpy( data, memory + pos, length );
+					pos += length;
+				}
+			}
+
+			dword Loader::Fetch32()
+			{
+				u8 data[4];
+				Fetch( data, 4 );
+				return data[0] | (data[1] << 8) | (data[2] << 16) | (dword(data[3]) << 24);
+			}
+
 			dword Loader::Begin()
 			{
 				dword id = 0;
 
-				if (lengths.Size() == 0 || stream.GetPos() != lengths.Back())
+				if (lengths.Size() == 0 || GetPos() != lengths.Back())
 				{
-					id = stream.Read32();
-					const dword length = stream.Read32();
-					chunks << (stream.GetPos() + length);
+					id = Fetch32();
+					const dword length = Fetch32();
+					chunks << (GetPos() + length);
 				}
 
 				return id;
@@ -184,37 +513,45 @@ namespace Nes
 
 			void Loader::End()
 			{
-				stream.SetPos( chunks.Pop() );
+				SetPos( chunks.Pop() );
 			}
 
 			void Loader::CheckRead(dword length)
 			{
-				if (stream.GetPos() + length > chunks.Back())
+				if (GetPos() + length > chunks.Back())
 					throw RESULT_ERR_CORRUPT_FILE;
 			}
 
 			uint Loader::Read8()
 			{
 				CheckRead( 1 );
-				return stream.Read8();
+
+				u8 data;
+				Fetch( &data, 1 );
+
+				return data;
 			}
 
 			uint Loader::Read16()
 			{
 				CheckRead( 2 );
-				return stream.Read16();
+
+				u8 data[2];
+				Fetch( data, 2 );
+
+				return data[0] | (data[1] << 8);
 			}
 
 			dword Loader::Read32()
 			{
 				CheckRead( 4 );
-				return stream.Read32();
+				return Fetch32();
 			}
 
 			void Loader::Read(u8* const data,const dword length)
 			{
 				CheckRead( length );
-				stream.Read( data, length );
+				Fetch( data, length );
 			}
 
 			void Loader::Uncompress(u8* const data,const dword length)
@@ -232,7 +569,7 @@ namespace Nes
 					{
                       #ifndef NST_NO_ZLIB
 
-						const Vector<u8> buffer( chunks.Back() - stream.GetPos() );
+						const Vector<u8> buffer( chunks.Back() - GetPos() );
 						Read( buffer.Begin(), buffer.Size() );
 
 						ulong uncompressed = length;
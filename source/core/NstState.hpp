@@ -46,11 +46,23 @@ namespace Nes
 				MIN_CHUNK_SIZE = 4 + 4
 			};
 
+			class Capture;
+
 			class Saver
 			{
 			public:
 
-				Saver(StdStream,bool,bool);
+				enum Compression
+				{
+					COMPRESSION_NONE,
+					COMPRESSION_BEST,
+					COMPRESSION_FAST
+				};
+
+				Saver(StdStream,uint,bool);
+				Saver(void*,dword,uint,bool);
+				Saver(void*,dword,const void*,dword,bool);
+				Saver(Capture&,bool);
 				~Saver();
 
 				Saver& Begin(dword);
@@ -61,6 +73,10 @@ namespace Nes
 				Saver& Write(const void*,dword);
 				Saver& Compress(const u8*,dword);
 
+				dword Diff();
+
+				static dword Materialize(const void*,dword,const void*,dword,void*,dword);
+
 				class Subset
 				{
 					Saver& saver;
@@ -92,14 +108,44 @@ namespace Nes
 
 			private:
 
-				Stream::Out stream;
+				friend class Capture;
+
+				dword GetPos() const;
+				void Store(dword,const u8*,dword);
+
+				static void Put32(u8*,dword);
+				static dword Get32(const u8*);
+
+				// either a stream or a caller's block of memory, in the latter
+				// case writing past the end only counts up the length needed
+
+				StdStream const stream;
+				u8* const memory;
+				const dword capacity;
+				dword pos;
 				Vector<u32> chunks;
-				const bool useCompression;
+				const uint compression;
 				const bool internal;
 
+				// snapshot mode, the state is built up in the image and Diff()
+				// puts its length in the memory followed by only those pages
+				// that differ from the base, each one as its index and contents
+
+				const u8* const base;
+				const dword baseLength;
+				Vector<u8> scratch;
+
+				// capture mode, the state goes uncompressed into the capture's
+				// image along with where its chunks and compressed blocks are
+
+				Capture* const capture;
+				Vector<u8>* const image;
+
 				enum
 				{
-					CHUNK_RESERVE = 8
+					CHUNK_RESERVE = 8,
+					PAGE_SIZE = 0x100,
+					PAGE_RECORD = 4 + PAGE_SIZE
 				};
 
 			public:
@@ -121,20 +167,56 @@ namespace Nes
 					return Compress( data, N );
 				}
 
-				Stream::Out& GetStream()
+				Stream::Out GetStream() const
 				{
-					return stream;
+					return Stream::Out( stream );
 				}
 
-				const Stream::Out& GetStream() const
+				bool Internal() const
 				{
-					return stream;
+					return internal;
 				}
 
-				bool Internal() const
+				dword Length() const
 				{
-					return internal;
+					return pos;
+				}
+			};
+
+			class Capture
+			{
+			public:
+
+				Capture();
+
+				void Save(StdStream,uint) const;
+
+				dword Length() const
+				{
+					return image.Size();
 				}
+
+			private:
+
+				friend class Saver;
+
+				enum
+				{
+					MARK_BEGIN,
+					MARK_END,
+					MARK_BLOCK
+				};
+
+				struct Mark
+				{
+					dword type;
+					dword pos;
+					dword length;
+				};
+
+				Vector<u8> image;
+				Vector<Mark> marks;
+				bool internal;
 			};
 
 			class Loader
@@ -142,6 +224,7 @@ namespace Nes
 			public:
 
 				explicit Loader(StdStream);
+				Loader(const void*,dword);
 				~Loader();
 
 				dword Begin();
@@ -207,8 +290,15 @@ namespace Nes
 			private:
 
 				void CheckRead(dword);
-
-				Stream::In stream;
+				void Fetch(void*,dword);
+				dword Fetch32();
+				dword GetPos() const;
+				void SetPos(dword);
+
+				StdStream const stream;
+				const u8* const memory;
+				const dword size;
+				dword pos;
 				Vector<u32> chunks;
 				Vector<u32> lengths;
 
@@ -226,14 +316,9 @@ namespace Nes
 					Uncompress( data, N );
 				}
 
-				Stream::In& GetStream()
-				{
-					return stream;
-				}
-
-				const Stream::In& GetStream() const
+				Stream::In GetStream() const
 				{
-					return stream;
+					return Stream::In( stream );
 				}
 			};
 		}
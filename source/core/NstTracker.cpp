@@ -28,6 +28,7 @@
 #include "NstTrackerRewinder.hpp"
 #include "NstImage.hpp"
 #include "api/NstApiMachine.hpp"
+#include "api/NstApiRewinder.hpp"
 
 namespace Nes
 {
@@ -39,9 +40,10 @@ namespace Nes
 
 		Tracker::Tracker()
 		:
-		rewinder      (NULL),
-		movie         (NULL),
-		rewinderSound (false)
+		rewinder       (NULL),
+		movie          (NULL),
+		rewinderSound  (false),
+		rewinderMemory (Api::Rewinder::DEFAULT_MEMORY_BUDGET)
 		{}
 
 		Tracker::~Tracker()
@@ -109,7 +111,8 @@ namespace Nes
 					&Machine::SaveState,
 					emulator->cpu,
 					emulator->ppu,
-					rewinderSound
+					rewinderSound,
+					rewinderMemory
 				);
 			}
 			else
@@ -121,6 +124,21 @@ namespace Nes
 			return RESULT_OK;
 		}
 
+		Result Tracker::RewinderSetMemoryBudget(const dword budget)
+		{
+			if (rewinder)
+			{
+				const Result result = rewinder->SetMemoryBudget( budget );
+
+				if (NES_FAILED(result))
+					return result;
+			}
+
+			rewinderMemory = budget;
+
+			return RESULT_OK;
+		}
+
 		Result Tracker::MoviePlay(Machine& emulator,StdStream stream,bool mode)
 		{
 			if (!rewinder && emulator.Is(Api::Machine::GAME))
@@ -58,6 +58,7 @@ namespace Nes
 			Rewinder* rewinder;
 			Movie* movie;
 			ibool rewinderSound;
+			dword rewinderMemory;
 
 		public:
 
@@ -76,6 +77,7 @@ namespace Nes
 			void   RewinderReset() const;
 			Result RewinderStart() const;
 			Result RewinderStop() const;
+			Result RewinderSetMemoryBudget(dword);
 			bool   IsRewinding() const;
 
 			Result MoviePlay(Machine&,StdStream,bool);
@@ -97,6 +99,11 @@ namespace Nes
 				return rewinderSound;
 			}
 
+			dword RewinderGetMemoryBudget() const
+			{
+				return rewinderMemory;
+			}
+
 			bool MovieIsInserted() const
 			{
 				return movie != NULL;
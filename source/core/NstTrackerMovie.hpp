@@ -36,7 +36,7 @@ namespace Nes
 		class Tracker::Movie
 		{
 			typedef Result (Machine::*EmuLoadState)(StdStream,bool);
-			typedef Result (Machine::*EmuSaveState)(StdStream,bool,bool);
+			typedef Result (Machine::*EmuSaveState)(StdStream,uint,bool);
 			typedef Result (Machine::*EmuReset)(bool);
 
 		public:
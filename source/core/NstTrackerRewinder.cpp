@@ -23,19 +23,10 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include <new>
-#include <string>
 #include "NstMachine.hpp"
 #include "NstTrackerRewinder.hpp"
 #include "api/NstApiRewinder.hpp"
 
-#ifndef NST_NO_ZLIB
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN
-#define ZLIB_WINAPI
-#endif
-#include "../zlib/zlib.h"
-#endif
-
 namespace Nes
 {
 	namespace Core
@@ -110,9 +101,11 @@ namespace Nes
 		apu     (a)
 		{}
 
-		Tracker::Rewinder::Rewinder(Machine& e,EmuExecute x,EmuLoadState l,EmuSaveState s,Cpu& c,Ppu& p,bool b)
+		Tracker::Rewinder::Rewinder(Machine& e,EmuExecute x,EmuLoadState l,EmuSaveState s,Cpu& c,Ppu& p,bool b,dword m)
 		:
 		rewinding    (false),
+		key          (keys+0),
+		spare        (keys+1),
 		sound        (c.GetApu(),b),
 		video        (p),
 		emulator     (e),
@@ -122,6 +115,7 @@ namespace Nes
 		cpu          (c),
 		ppu          (p)
 		{
+			history.Reserve( m );
 			Reset( false );
 		}
 
@@ -140,16 +134,34 @@ namespace Nes
 			LinkPorts( false );
 		}
 
-		void Tracker::Rewinder::Key::Input::Reset()
+		void Tracker::Rewinder::Key::Reset()
 		{
 			pos = BAD_POS;
-			buffer.Destroy();
+			state.Clear();
+			input.Clear();
 		}
 
-		void Tracker::Rewinder::Key::Reset()
+		void Tracker::Rewinder::History::Reserve(const dword budget)
+		{
+			Clear();
+
+			entries.Destroy();
+			arena.Destroy();
+
+			// one index slot for every MIN_KEY_SIZE bytes of
+			// budget, whatever is left over goes to the arena
+
+			const dword size = budget / MIN_KEY_SIZE;
+
+			entries.Resize( size );
+			arena.Resize( budget - size * sizeof(Entry) );
+		}
+
+		void Tracker::Rewinder::History::Clear()
 		{
-			stream.str( std::string() );
-			input.Reset();
+			head = 0;
+			first = 0;
+			count = 0;
 		}
 
 		void Tracker::Rewinder::Reset(bool on)
@@ -165,10 +177,10 @@ namespace Nes
 
 			uturn = false;
 			frame = LAST_FRAME;
-			key = keys + LAST_KEY;
 
-			for (uint i=0; i < NUM_FRAMES; ++i)
-				keys[i].Reset();
+			history.Clear();
+			keys[0].Reset();
+			keys[1].Reset();
 
 			LinkPorts( on );
 		}
@@ -248,229 +260,352 @@ namespace Nes
 		#pragma optimize("", on)
 		#endif
 
-		inline void Tracker::Rewinder::Key::Input::Invalidate()
+		inline void Tracker::Rewinder::Key::Invalidate()
 		{
 			pos = BAD_POS;
 		}
 
-		inline void Tracker::Rewinder::Key::Input::BeginForward()
+		inline bool Tracker::Rewinder::Key::CanRewind() const
 		{
-			const ulong hint = pos;
-			pos = 0;
-			buffer.Clear();
-
-			if (hint != BAD_POS)
-				buffer.Reserve( hint );
+			return pos != BAD_POS;
 		}
 
-		bool Tracker::Rewinder::Key::Input::EndForward()
+		inline bool Tracker::Rewinder::Key::ResumeForward()
 		{
-			if (pos == 0)
+			if (pos != BAD_POS)
 			{
-				pos = buffer.Size();
-
-			#ifndef NST_NO_ZLIB
-				if (pos >= MIN_COMPRESSION_SIZE)
-				{
-					{
-						ulong size = pos - 1;
-						Buffer tmp( size );
+				input.SetTo( pos );
+				pos = 0;
+				return true;
+			}
 
-						if (compress( tmp.Begin(), &size, buffer.Begin(), buffer.Size() ) == Z_OK)
-						{
-							NST_ASSERT( size < pos );
-							tmp.SetTo( size );
-							Buffer::Swap( tmp, buffer );
-						}
-						else
-						{
-							NST_DEBUG_MSG("compress() in Tracker::Rewinder::Key::Input failed!");
-						}
-					}
+			return false;
+		}
 
-					buffer.Defrag();
+		inline uint Tracker::Rewinder::Key::Put(const uint data)
+		{
+			if (pos != BAD_POS)
+			{
+				try
+				{
+					input << data;
+				}
+				catch (...)
+				{
+					NST_DEBUG_MSG("input << data failed!");
+					pos = BAD_POS;
 				}
-			#endif
-
-				return true;
 			}
 
-			return false;
+			return data;
+		}
+
+		inline uint Tracker::Rewinder::Key::Get()
+		{
+			if (pos < input.Size())
+			{
+				return input[pos++];
+			}
+			else
+			{
+				NST_DEBUG_MSG("input >> data failed!");
+				pos = BAD_POS;
+				return OPEN_BUS;
+			}
 		}
 
-		bool Tracker::Rewinder::Key::Input::BeginBackward()
+		bool Tracker::Rewinder::Key::BeginForward(Machine& emulator,EmuSaveState saveState)
 		{
-			ulong size = pos;
 			pos = 0;
+			input.Clear();
 
-		#ifndef NST_NO_ZLIB
-			if (size > buffer.Size())
+			try
 			{
-				Buffer tmp( size );
+				dword length = state.Capacity();
+				Result result = (emulator.*saveState)( state.Begin(), length, false, true );
 
-				if (uncompress( tmp.Begin(), &size, buffer.Begin(), buffer.Size() ) == Z_OK)
+				if (length > state.Capacity())
 				{
-					NST_VERIFY( size == tmp.Size() );
-					Buffer::Swap( tmp, buffer );
+					// first key or a bigger state, make room and go again
+
+					state.Reserve( length );
+					result = (emulator.*saveState)( state.Begin(), length, false, true );
 				}
-				else
+
+				if (NES_SUCCEEDED(result) && length <= state.Capacity())
 				{
-					NST_DEBUG_MSG("uncompress() in Tracker::Rewinder::Key::Input failed!");
-					return false;
+					state.SetTo( length );
+					return true;
 				}
 			}
-		#endif
+			catch (...)
+			{
+				NST_DEBUG_MSG("Tracker::Rewinder::Key::BeginForward() failed!");
+			}
 
-			return true;
+			Reset();
+			return false;
 		}
 
-		inline void Tracker::Rewinder::Key::Input::EndBackward()
+		bool Tracker::Rewinder::Key::BeginForward(Machine& emulator,EmuLoadState loadState)
 		{
 			pos = 0;
+			input.Clear();
+
+			return TurnForward( emulator, loadState );
 		}
 
-		inline bool Tracker::Rewinder::Key::Input::ResumeForward()
+		bool Tracker::Rewinder::Key::TurnForward(Machine& emulator,EmuLoadState loadState)
 		{
-			if (pos != BAD_POS)
+			return NES_SUCCEEDED((emulator.*loadState)( state.Begin(), state.Size(), false ));
+		}
+
+		bool Tracker::Rewinder::Key::BeginBackward(Machine& emulator,EmuLoadState loadState)
+		{
+			pos = 0;
+			return TurnForward( emulator, loadState );
+		}
+
+		inline void Tracker::Rewinder::Key::EndBackward()
+		{
+			pos = 0;
+		}
+
+		void Tracker::Rewinder::History::Evict()
+		{
+			NST_ASSERT( count );
+
+			if (++first == entries.Size())
+				first = 0;
+
+			--count;
+		}
+
+		dword Tracker::Rewinder::History::PackSize(const dword length)
+		{
+			return length + (length + MAX_LITERALS-1) / MAX_LITERALS;
+		}
+
+		u8* Tracker::Rewinder::History::PackLiterals(const u8* src,const u8* const end,u8* dst)
+		{
+			while (src != end)
 			{
-				ulong size = pos;
-				pos = 0;
-				buffer.Resize( size );
-				return true;
+				const dword length = NST_MIN(dword(end - src),dword(MAX_LITERALS));
+
+				*dst++ = length - 1;
+				std::memcpy( dst, src, length );
+
+				dst += length;
+				src += length;
 			}
 
-			return false;
+			return dst;
 		}
 
-		inline bool Tracker::Rewinder::Key::Input::CanRewind() const
+		u8* Tracker::Rewinder::History::Pack(const u8* src,const u8* const end,u8* dst)
 		{
-			return pos != BAD_POS;
+			const u8* literals = src;
+
+			while (src != end)
+			{
+				const u8* next = src + 1;
+
+				while (next != end && *next == *src && next - src < MAX_RUN)
+					++next;
+
+				if (next - src >= MIN_RUN)
+				{
+					dst = PackLiterals( literals, src, dst );
+
+					*dst++ = 0x80 | (next - src - MIN_RUN);
+					*dst++ = *src;
+
+					literals = next;
+				}
+
+				src = next;
+			}
+
+			return PackLiterals( literals, end, dst );
 		}
 
-		inline uint Tracker::Rewinder::Key::Input::Put(const uint data)
+		const u8* Tracker::Rewinder::History::Unpack(const u8* src,const u8* const end,u8* dst,u8* const dstEnd)
 		{
-			if (pos != BAD_POS)
+			while (dst != dstEnd)
 			{
-				try
+				if (src == end)
+					return NULL;
+
+				const uint token = *src++;
+
+				if (token & 0x80)
 				{
-					buffer << data;
+					const dword length = (token & 0x7F) + MIN_RUN;
+
+					if (src == end || length > dword(dstEnd - dst))
+						return NULL;
+
+					std::memset( dst, *src++, length );
+					dst += length;
 				}
-				catch (...)
+				else
 				{
-					NST_DEBUG_MSG("buffer << data failed!");
-					pos = BAD_POS;
+					const dword length = token + 1;
+
+					if (length > dword(end - src) || length > dword(dstEnd - dst))
+						return NULL;
+
+					std::memcpy( dst, src, length );
+					dst += length;
+					src += length;
 				}
 			}
 
-			return data;
+			return src;
 		}
 
-		inline uint Tracker::Rewinder::Key::Input::Get()
+		void Tracker::Rewinder::History::Push(const Key& key,const Key& next)
 		{
-			if (pos < buffer.Size())
+			if (!entries.Size())
+				return;
+
+			const dword size = key.state.Size();
+			dword length;
+
+			try
 			{
-				return buffer[pos++];
+				delta.Resize( size );
+				packed.Resize( PackSize(size) + PackSize(key.input.Size()) );
 			}
-			else
+			catch (...)
 			{
-				NST_DEBUG_MSG("buffer >> data failed!");
-				pos = BAD_POS;
-				return OPEN_BUS;
+				NST_DEBUG_MSG("Tracker::Rewinder::History::Push() failed!");
+				Clear();
+				return;
 			}
-		}
 
-		inline void Tracker::Rewinder::Key::Invalidate()
-		{
-			input.Invalidate();
-		}
+			{
+				// stored against the next key, little of a state
+				// changes in a second so the delta is mostly zeros
 
-		inline bool Tracker::Rewinder::Key::CanRewind() const
-		{
-			return input.CanRewind();
-		}
+				const u8* const NST_RESTRICT src = key.state.Begin();
+				const u8* const NST_RESTRICT base = next.state.Begin();
+				u8* const NST_RESTRICT dst = delta.Begin();
 
-		inline bool Tracker::Rewinder::Key::ResumeForward()
-		{
-			return input.ResumeForward();
-		}
+				const dword common = NST_MIN(size,next.state.Size());
 
-		bool Tracker::Rewinder::Key::BeginForward(Machine& emulator,EmuSaveState saveState,EmuLoadState loadState)
-		{
-			NST_ASSERT( !(bool(saveState) && bool(loadState)) );
+				for (dword i=0; i < common; ++i)
+					dst[i] = src[i] ^ base[i];
 
-			input.BeginForward();
+				std::memcpy( dst + common, src + common, size - common );
 
-			if (saveState)
-			{
-				stream.seekp( 0, std::stringstream::beg );
-				stream.clear();
+				u8* const end = Pack( delta.Begin(), delta.End(), packed.Begin() );
+				length = Pack( key.input.Begin(), key.input.End(), end ) - packed.Begin();
+			}
 
-				return NES_SUCCEEDED((emulator.*saveState)( &static_cast<std::ostream&>(stream), false, true ));
+			if (length > arena.Size())
+			{
+				Clear();
+				return;
 			}
-			else if (loadState)
+
+			if (count == entries.Size())
+				Evict();
+
+			if (!count)
+				head = 0;
+
+			dword offset = head;
+
+			if (arena.Size() - offset < length)
 			{
-				stream.seekg( 0, std::stringstream::beg );
-				stream.clear();
+				while (count && entries[first].offset >= head)
+					Evict();
 
-				return NES_SUCCEEDED((emulator.*loadState)( &static_cast<std::istream&>(stream), false ));
+				offset = 0;
 			}
 
-			return true;
-		}
+			while (count && entries[first].offset >= offset && entries[first].offset - offset < length)
+				Evict();
 
-		void Tracker::Rewinder::Key::EndForward()
-		{
-			if (!input.EndForward())
-				Reset();
-		}
+			dword index = first + count++;
 
-		bool Tracker::Rewinder::Key::TurnForward(Machine& emulator,EmuLoadState loadState)
-		{
-			stream.seekg( 0, std::stringstream::beg );
-			stream.clear();
+			if (index >= entries.Size())
+				index -= entries.Size();
 
-			return NES_SUCCEEDED((emulator.*loadState)( &static_cast<std::istream&>(stream), false ));
-		}
+			Entry& entry = entries[index];
 
-		bool Tracker::Rewinder::Key::BeginBackward(Machine& emulator,EmuLoadState loadState)
-		{
-			NST_VERIFY( CanRewind() );
-			return TurnForward( emulator, loadState ) && input.BeginBackward();
-		}
+			entry.offset = offset;
+			entry.length = length;
+			entry.state = size;
+			entry.input = key.input.Size();
 
-		inline void Tracker::Rewinder::Key::EndBackward()
-		{
-			input.EndBackward();
+			std::memcpy( arena.Begin() + offset, packed.Begin(), length );
+			head = offset + length;
 		}
 
-		inline uint Tracker::Rewinder::Key::Put(uint data)
+		bool Tracker::Rewinder::History::Pop(Key& key,const Key& next)
 		{
-			return input.Put( data );
-		}
+			if (!count)
+				return false;
 
-		inline uint Tracker::Rewinder::Key::Get()
-		{
-			return input.Get();
-		}
+			dword index = first + --count;
 
-		inline Tracker::Rewinder::Key* Tracker::Rewinder::PrevKey(Key* key)
-		{
-			return (key != keys ? key-1 : keys+LAST_KEY);
-		}
+			if (index >= entries.Size())
+				index -= entries.Size();
 
-		inline Tracker::Rewinder::Key* Tracker::Rewinder::PrevKey()
-		{
-			return PrevKey( key );
+			const Entry& entry = entries[index];
+			head = entry.offset;
+
+			try
+			{
+				key.state.Resize( entry.state );
+				key.input.Resize( entry.input );
+			}
+			catch (...)
+			{
+				NST_DEBUG_MSG("Tracker::Rewinder::History::Pop() failed!");
+				Clear();
+				return false;
+			}
+
+			const u8* const end = arena.Begin() + entry.offset + entry.length;
+			const u8* src = Unpack( arena.Begin() + entry.offset, end, key.state.Begin(), key.state.End() );
+
+			if (src)
+				src = Unpack( src, end, key.input.Begin(), key.input.End() );
+
+			if (src != end)
+			{
+				NST_DEBUG_MSG("Tracker::Rewinder::History::Pop() failed!");
+				Clear();
+				return false;
+			}
+
+			u8* const NST_RESTRICT dst = key.state.Begin();
+			const u8* const NST_RESTRICT base = next.state.Begin();
+
+			for (dword i=0, n=NST_MIN(entry.state,next.state.Size()); i < n; ++i)
+				dst[i] ^= base[i];
+
+			return true;
 		}
 
-		inline Tracker::Rewinder::Key* Tracker::Rewinder::NextKey(Key* key)
+		void Tracker::Rewinder::SwapKeys()
 		{
-			return (key != keys+LAST_KEY ? key+1 : keys);
+			Key* const tmp = key;
+			key = spare;
+			spare = tmp;
 		}
 
-		inline Tracker::Rewinder::Key* Tracker::Rewinder::NextKey()
+		void Tracker::Rewinder::NextKey()
 		{
-			return NextKey( key );
+			if (spare->BeginForward( emulator, emuSaveState ) && key->CanRewind())
+				history.Push( *key, *spare );
+			else
+				history.Clear();
+
+			SwapKeys();
 		}
 
 		void Tracker::Rewinder::LinkPorts(bool on)
@@ -490,7 +625,7 @@ namespace Nes
 
 		void Tracker::Rewinder::ReverseSound::Clear() const
 		{
-			std::memset( buffer, bits == 16 ? 0x00 : 0x80, size );
+			std::memset( buffer, bits == 8 ? 0x80 : 0x00, size );
 		}
 
 		inline void Tracker::Rewinder::ReverseVideo::Flush(const Mutex& mutex)
@@ -572,7 +707,9 @@ namespace Nes
 		{
 			if (target && (!mutex.funcLock || mutex.funcLock( mutex.userLock, *target )))
 			{
-				if (bits == 16)
+				if (bits == 32)
+					ReverseCopy<float>( *target );
+				else if (bits == 16)
 					ReverseCopy<i16>( *target );
 				else
 					ReverseCopy<u8>( *target );
@@ -627,9 +764,7 @@ namespace Nes
 				if (++frame == NUM_FRAMES)
 				{
 					frame = 0;
-					key->EndForward();
-					key = NextKey();
-					key->BeginForward( emulator, emuSaveState, NULL );
+					NextKey();
 				}
 			}
 			else
@@ -639,28 +774,26 @@ namespace Nes
 					frame = 0;
 					key->EndBackward();
 
-					Key* const prev = PrevKey();
-
-					if (!prev->CanRewind())
+					if (history.IsEmpty())
 					{
 						rewinding = false;
 
 						key->Invalidate();
-						key = NextKey();
-						key->BeginForward( emulator, NULL, emuLoadState );
+						SwapKeys();
+						key->BeginForward( emulator, emuLoadState );
 
 						LinkPorts();
 
 						return (emulator.*emuExecute)( videoOut, soundOut, inputOut );
 					}
 
-					if (!prev->BeginBackward( emulator, emuLoadState ))
+					if (!history.Pop( *spare, *key ) || !spare->BeginBackward( emulator, emuLoadState ))
 					{
 						Reset();
 						return (emulator.*emuExecute)( videoOut, soundOut, inputOut );
 					}
 
-					key = prev;
+					SwapKeys();
 				}
 
 				const ReverseVideo::Mutex videoMutex( video );
@@ -694,8 +827,6 @@ namespace Nes
 					}
 				}
 
-				NextKey()->Invalidate();
-
 				if (!video.Begin() || !sound.Begin() || !key->BeginBackward( emulator, emuLoadState ))
 				{
 					Reset();
@@ -741,7 +872,9 @@ namespace Nes
 					if (++frame == NUM_FRAMES)
 					{
 						frame = 0;
-						key = NextKey();
+
+						history.Push( *key, *spare );
+						SwapKeys();
 
 						if (!key->TurnForward( emulator, emuLoadState ))
 						{
@@ -777,7 +910,7 @@ namespace Nes
 			if (rewinding)
 				return RESULT_NOP;
 
-			if (uturn || !PrevKey()->CanRewind())
+			if (uturn || history.IsEmpty())
 				return RESULT_ERR_NOT_READY;
 
 			uturn = true;
@@ -800,6 +933,16 @@ namespace Nes
 			return RESULT_OK;
 		}
 
+		Result Tracker::Rewinder::SetMemoryBudget(const dword budget)
+		{
+			if (rewinding || uturn)
+				return RESULT_ERR_NOT_READY;
+
+			history.Reserve( budget );
+
+			return RESULT_OK;
+		}
+
 		NES_PEEK(Tracker::Rewinder,Port_Put)
 		{
 			return key->Put( ports[address-0x4016]->Peek( address ) );
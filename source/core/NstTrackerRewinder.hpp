@@ -29,7 +29,6 @@
 #pragma once
 #endif
 
-#include <sstream>
 #include "api/NstApiSound.hpp"
 
 namespace Nes
@@ -39,72 +38,52 @@ namespace Nes
 		class Tracker::Rewinder
 		{
 			typedef Result (Machine::*EmuExecute)(Video::Output*,Sound::Output*,Input::Controllers*);
-			typedef Result (Machine::*EmuSaveState)(StdStream,bool,bool);
-			typedef Result (Machine::*EmuLoadState)(StdStream,bool);
+			typedef Result (Machine::*EmuSaveState)(void*,dword&,uint,bool);
+			typedef Result (Machine::*EmuLoadState)(const void*,dword,bool);
 
 		public:
 
-			Rewinder(Machine&,EmuExecute,EmuLoadState,EmuSaveState,Cpu&,Ppu&,bool);
+			Rewinder(Machine&,EmuExecute,EmuLoadState,EmuSaveState,Cpu&,Ppu&,bool,dword);
 			~Rewinder();
 
 			Result Start();
 			Result Stop();
 			Result Execute(Video::Output*,Sound::Output*,Input::Controllers*);
+			Result SetMemoryBudget(dword);
 
 		private:
 
 			void Reset(bool);
 			void LinkPorts(bool=true);
 			void ChangeDirection();
+			void NextKey();
+			void SwapKeys();
 
 			enum
 			{
-				NUM_KEYS = 60,
-				LAST_KEY = NUM_KEYS-1,
 				NUM_FRAMES = 60,
 				LAST_FRAME = NUM_FRAMES-1
 			};
 
 			class Key
 			{
-				class Input
+				enum
 				{
-					typedef Vector<u8> Buffer;
-
-					enum
-					{
-						BAD_POS = INT_MAX,
-						MIN_COMPRESSION_SIZE = 1024,
-						OPEN_BUS = 0x40
-					};
-
-					ulong pos;
-					Buffer buffer;
-
-				public:
-
-					void Reset();
-					inline void BeginForward();
-					bool EndForward();
-					bool BeginBackward();
-					inline void EndBackward();
-
-					inline uint Put(uint);
-					inline uint Get();
-
-					inline bool ResumeForward();
-					inline bool CanRewind() const;
-					inline void Invalidate();
+					BAD_POS = INT_MAX,
+					OPEN_BUS = 0x40
 				};
 
-				Input input;
-				std::stringstream stream;
+				dword pos;
 
 			public:
 
+				Vector<u8> state;
+				Vector<u8> input;
+
 				void Reset();
-				bool BeginForward(Machine&,EmuSaveState,EmuLoadState);
-				void EndForward();
+				bool BeginForward(Machine&,EmuSaveState);
+				bool BeginForward(Machine&,EmuLoadState);
+				bool TurnForward(Machine&,EmuLoadState);
 				bool BeginBackward(Machine&,EmuLoadState);
 				inline void EndBackward();
 
@@ -113,10 +92,59 @@ namespace Nes
 
 				inline bool CanRewind() const;
 				inline bool ResumeForward();
-				inline bool TurnForward(Machine&,EmuLoadState);
 				inline void Invalidate();
 			};
 
+			class History
+			{
+			public:
+
+				void Reserve(dword);
+				void Clear();
+				void Push(const Key&,const Key&);
+				bool Pop(Key&,const Key&);
+
+			private:
+
+				enum
+				{
+					MIN_KEY_SIZE = 512,
+					MIN_RUN = 3,
+					MAX_RUN = 0x7F + MIN_RUN,
+					MAX_LITERALS = 0x80
+				};
+
+				struct Entry
+				{
+					dword offset;
+					dword length;
+					dword state;
+					dword input;
+				};
+
+				void Evict();
+
+				static dword PackSize(dword);
+				static u8* PackLiterals(const u8*,const u8*,u8*);
+				static u8* Pack(const u8*,const u8*,u8*);
+				static const u8* Unpack(const u8*,const u8*,u8*,u8*);
+
+				dword head;
+				dword first;
+				dword count;
+				Vector<Entry> entries;
+				Vector<u8> arena;
+				Vector<u8> delta;
+				Vector<u8> packed;
+
+			public:
+
+				bool IsEmpty() const
+				{
+					return !count;
+				}
+			};
+
 			class ReverseVideo
 			{
 			public:
@@ -196,11 +224,6 @@ namespace Nes
 				}
 			};
 
-			inline Key* PrevKey(Key*);
-			inline Key* PrevKey();
-			inline Key* NextKey(Key*);
-			inline Key* NextKey();
-
 			NES_DECL_PEEK( Port_Get )
 			NES_DECL_PEEK( Port_Put )
 			NES_DECL_POKE( Port     )
@@ -212,7 +235,9 @@ namespace Nes
 			const Io::Port* ports[2];
 
 			Key* key;
-			Key keys[NUM_KEYS];
+			Key* spare;
+			Key keys[2];
+			History history;
 
 			ReverseSound sound;
 			ReverseVideo video;
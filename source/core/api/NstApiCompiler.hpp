@@ -66,6 +66,10 @@
 // #define NST_TAILCALL_OPTIMIZE - define this if the compiler supports tail-call optimizations
 //                                 (automatically defined for MSVC and GCC)
 //
+// #define NST_CPU_SWITCH_DISPATCH - dispatch CPU opcodes through a switch statement instead of the member function
+//                           pointer table, lets the compiler inline the instruction handlers into the main loop.
+//                           which one is faster depends on the compiler, profile both.
+//
 // #define NST_NO_ZLIB - omit ZLib support, warning: if you do, compressed states and movie files can't be saved/loaded!
 //
 // #define NST_NO_SCALE2X - omit Scale2x and Scale3x filter
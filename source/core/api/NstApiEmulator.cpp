@@ -22,27 +22,135 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
 #include "../NstMachine.hpp"
+#include "../NstImage.hpp"
+#include "../NstState.hpp"
 #include "NstApiEmulator.hpp"
+#include "NstApiMachine.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
 
 namespace Nes
 {
 	namespace Api
 	{
+		class Emulator::RunAhead
+		{
+		public:
+
+			RunAhead(uint,Core::Machine*);
+
+			Result Execute(Core::Machine&,Core::Video::Output*,Core::Sound::Output*,Core::Input::Controllers*);
+			ulong GetOverhead();
+
+			const uint frames;
+			Core::Machine* const shadow;
+
+		private:
+
+			static qword Clock();
+
+			Core::Vector<u8> state;
+			qword spent;
+			dword count;
+		};
+
 		#ifdef NST_PRAGMA_OPTIMIZE
 		#pragma optimize("s", on)
 		#endif
 
 		Emulator::Emulator()
-		: machine(*new Core::Machine)
+		: machine(*new Core::Machine), runAhead(NULL)
 		{
 		}
 
 		Emulator::~Emulator()
 		{
+			delete runAhead;
 			delete &machine;
 		}
 
+		Emulator::RunAhead::RunAhead(uint f,Core::Machine* s)
+		: frames(f), shadow(s), spent(0), count(0)
+		{
+		}
+
+		qword Emulator::RunAhead::Clock()
+		{
+			#ifdef _WIN32
+
+			LARGE_INTEGER counter, frequency;
+
+			if (!::QueryPerformanceCounter( &counter ) || !::QueryPerformanceFrequency( &frequency ) || !frequency.QuadPart)
+				return 0;
+
+			const qword ticks = counter.QuadPart;
+			const qword rate = frequency.QuadPart;
+
+			return ticks / rate * 1000000 + ticks % rate * 1000000 / rate;
+
+			#else
+
+			timespec now;
+
+			if (::clock_gettime( CLOCK_MONOTONIC, &now ))
+				return 0;
+
+			return qword(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+
+			#endif
+		}
+
+		ulong Emulator::RunAhead::GetOverhead()
+		{
+			const ulong average = count ? ulong(spent / count) : 0;
+
+			spent = 0;
+			count = 0;
+
+			return average;
+		}
+
+		Result Emulator::SetRunAhead(uint frames,Emulator* shadow) throw()
+		{
+			if (frames > MAX_RUN_AHEAD || shadow == this)
+				return RESULT_ERR_INVALID_PARAM;
+
+			Core::Machine* const target = (frames && shadow ? &shadow->machine : NULL);
+
+			if (frames == GetRunAhead() && (!runAhead || runAhead->shadow == target))
+				return RESULT_NOP;
+
+			delete runAhead;
+			runAhead = NULL;
+
+			if (frames)
+			{
+				runAhead = new (std::nothrow) RunAhead( frames, target );
+
+				if (!runAhead)
+					return RESULT_ERR_OUT_OF_MEMORY;
+			}
+
+			return RESULT_OK;
+		}
+
+		uint Emulator::GetRunAhead() const throw()
+		{
+			return runAhead ? runAhead->frames : 0;
+		}
+
+		ulong Emulator::GetRunAheadOverhead() throw()
+		{
+			return runAhead ? runAhead->GetOverhead() : 0;
+		}
+
 		#ifdef NST_PRAGMA_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
@@ -54,7 +162,112 @@ namespace Nes
 			Core::Input::Controllers* input
 		)   throw()
 		{
+			if
+			(
+				runAhead && machine.Is(Machine::GAME) && machine.Is(Machine::ON) &&
+				!machine.tracker.RewinderIsEnabled() && !machine.tracker.MovieIsInserted() &&
+				!machine.LightGunIsConnected()
+			)
+			{
+				try
+				{
+					return runAhead->Execute( machine, video, sound, input );
+				}
+				catch (const std::bad_alloc&)
+				{
+					return RESULT_ERR_OUT_OF_MEMORY;
+				}
+				catch (...)
+				{
+					return RESULT_ERR_GENERIC;
+				}
+			}
+
 			return machine.tracker.Execute( machine, video, sound, input );
 		}
+
+		Result Emulator::RunAhead::Execute
+		(
+			Core::Machine& emulator,
+			Core::Video::Output* const video,
+			Core::Sound::Output* const sound,
+			Core::Input::Controllers* const input
+		)
+		{
+			// the frame for real, heard but not seen
+
+			Result result = emulator.ExecuteFrame( NULL, sound, input );
+
+			if (NES_FAILED(result) || !video)
+				return result;
+
+			const qword start = Clock();
+
+			dword length = state.Size();
+			result = emulator.SaveState( state.Begin(), length, Core::State::Saver::COMPRESSION_NONE, true );
+
+			if ((NES_SUCCEEDED(result) || result == RESULT_ERR_OUT_OF_MEMORY) && length > state.Size())
+			{
+				state.Resize( length );
+				result = emulator.SaveState( state.Begin(), length, Core::State::Saver::COMPRESSION_NONE, true );
+			}
+
+			if (NES_FAILED(result))
+				return result;
+
+			// the frames ahead, seen but not heard, either taken on from
+			// here by the second machine or run here and then taken back
+
+			const bool synth = emulator.cpu.GetApu().IsSynthRunning();
+			Core::Machine* target = &emulator;
+
+			if
+			(
+				shadow && shadow->Is(Machine::GAME) && shadow->Is(Machine::ON) &&
+				shadow->image->GetPrgCrc() == emulator.image->GetPrgCrc() &&
+				NES_SUCCEEDED(shadow->LoadState( state.Begin(), length, false ))
+			)
+				target = shadow;
+
+			const uint interval = target->renderInterval;
+			target->renderInterval = 1;
+
+			for (uint i=1; i < frames && NES_SUCCEEDED(result); ++i)
+				result = target->ExecuteFrame( NULL, NULL, input );
+
+			if (NES_SUCCEEDED(result))
+				result = target->ExecuteFrame( video, NULL, input );
+
+			target->renderInterval = interval;
+
+			if (target == &emulator)
+			{
+				const Result restored = emulator.LoadState( state.Begin(), length, false );
+
+				// the silent frames never touched the band-limiting synth, so
+				// it carries on from the restored state rather than resetting
+
+				if (synth && NES_SUCCEEDED(restored))
+					emulator.cpu.GetApu().ResumeSynth();
+
+				if (NES_SUCCEEDED(result))
+					result = restored;
+			}
+
+			spent += Clock() - start;
+			++count;
+
+			return result;
+		}
+
+		void Emulator::SetRenderInterval(uint interval) throw()
+		{
+			machine.renderInterval = interval;
+		}
+
+		uint Emulator::GetRenderInterval() const throw()
+		{
+			return machine.renderInterval;
+		}
 	}
 }
@@ -73,9 +73,37 @@ namespace Nes
 				Core::Input::Controllers*
 			)   throw();
 
+			void SetRenderInterval(uint) throw();
+			uint GetRenderInterval() const throw();
+
+			enum
+			{
+				MAX_RUN_AHEAD = 8
+			};
+
+			// Run-ahead, every frame is followed by the given number of frames
+			// more with the same input, the last of which is the one shown, and
+			// then put back to where it was. Hides as many frames of the game's
+			// own input lag. Given a second emulator with the same game loaded
+			// and powered on, input devices and video set up alike, the frames
+			// ahead are run on that one and this one is never put back. Left
+			// out while a movie or the rewinder is in use, and while a light
+			// gun is connected since it has to sense the frame that is shown.
+
+			Result SetRunAhead(uint,Emulator* =NULL) throw();
+			uint GetRunAhead() const throw();
+
+			// Average time in microseconds run-ahead has added to each
+			// frame shown since the last call.
+
+			ulong GetRunAheadOverhead() throw();
+
 		private:
 
+			class RunAhead;
+
 			Core::Machine& machine;
+			RunAhead* runAhead;
 
 		public:
 
@@ -22,12 +22,24 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
 #include "../NstMachine.hpp"
 #include "../NstCartridge.hpp"
 #include "../NstImage.hpp"
+#include "../NstState.hpp"
 #include "NstApiMachine.hpp"
 #include "NstApiMovie.hpp"
 #include "NstApiRewinder.hpp"
+#include "NstApiUser.hpp"
+
+#ifndef NST_NO_THREADS
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
 
 namespace Nes
 {
@@ -43,6 +55,21 @@ namespace Nes
 			return (emulator.state & what) && (emulator.state & that);
 		}
 
+		void Machine::EnableIdleLoopSkipping(bool enable) throw()
+		{
+			emulator.cpu.EnableIdleLoopSkipping( enable );
+		}
+
+		bool Machine::IsIdleLoopSkippingEnabled() const throw()
+		{
+			return emulator.cpu.IsIdleLoopSkippingEnabled();
+		}
+
+		qword Machine::GetIdleLoopSkippedCycles() const throw()
+		{
+			return emulator.cpu.GetIdleLoopSkippedCycles();
+		}
+
 		#ifdef NST_PRAGMA_OPTIMIZE
 		#pragma optimize("s", on)
 		#endif
@@ -223,7 +250,377 @@ namespace Nes
 
 		Result Machine::SaveState(std::ostream& stream,Compression compression) const throw()
 		{
-			return emulator.SaveState( &stream, compression != NO_COMPRESSION, false );
+			NST_COMPILE_ASSERT
+			(
+				uint(NO_COMPRESSION)   == Core::State::Saver::COMPRESSION_NONE &&
+				uint(USE_COMPRESSION)  == Core::State::Saver::COMPRESSION_BEST &&
+				uint(FAST_COMPRESSION) == Core::State::Saver::COMPRESSION_FAST
+			);
+
+			return emulator.SaveState( &stream, compression, false );
+		}
+
+		Result Machine::LoadState(const void* data,ulong length) throw()
+		{
+			if (data == NULL)
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (!emulator.tracker.MovieIsInserted() && !emulator.tracker.IsRewinding())
+			{
+				Api::Rewinder(emulator).Reset();
+				return emulator.LoadState( data, length );
+			}
+
+			return RESULT_ERR_NOT_READY;
+		}
+
+		Result Machine::SaveState(void* data,ulong& length,Compression compression) const throw()
+		{
+			dword size = length;
+			const Result result = emulator.SaveState( data, size, compression, false );
+			length = size;
+
+			return result;
+		}
+
+		Result Machine::SaveState(void* data,ulong& length,const void* base,ulong baseLength) const throw()
+		{
+			if (base == NULL)
+				return RESULT_ERR_INVALID_PARAM;
+
+			dword size = length;
+			const Result result = emulator.SaveState( data, size, base, baseLength, false );
+			length = size;
+
+			return result;
+		}
+
+		Result NST_CALL Machine::MaterializeState(const void* base,ulong baseLength,const void* delta,ulong deltaLength,void* data,ulong& length) throw()
+		{
+			if (base == NULL || delta == NULL)
+				return RESULT_ERR_INVALID_PARAM;
+
+			try
+			{
+				const dword size = Core::State::Saver::Materialize( base, baseLength, delta, deltaLength, data, length );
+				const bool fits = (size <= length);
+				length = size;
+
+				return (!data || fits) ? RESULT_OK : RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+		}
+
+		class Machine::Writer
+		{
+			struct Job
+			{
+				Job(std::ostream& s,uint c)
+				: next(NULL), stream(s), compression(c) {}
+
+				Job* next;
+				std::ostream& stream;
+				const uint compression;
+				Core::State::Capture capture;
+			};
+
+		public:
+
+			Writer();
+			~Writer();
+
+			Result Save(Core::Machine&,std::ostream&,uint);
+			void Wait();
+
+		private:
+
+			static void Write(const Job&);
+
+			#ifndef NST_NO_THREADS
+
+			void Lock();
+			void Unlock();
+			void Run();
+
+			#ifdef _WIN32
+			static DWORD WINAPI Run(LPVOID);
+			#else
+			static void* Run(void*);
+			#endif
+
+			// jobs are queued up for a thread that
+			// goes away again once it runs out of them
+
+			Job* head;
+			Job* tail;
+			bool running;
+
+			#ifdef _WIN32
+			CRITICAL_SECTION mutex;
+			HANDLE idle;
+			#else
+			pthread_mutex_t mutex;
+			pthread_cond_t idle;
+			#endif
+
+			#endif
+
+		public:
+
+			static Writer writer;
+		};
+
+		Machine::Writer Machine::Writer::writer;
+
+		#ifndef NST_NO_THREADS
+
+		Machine::Writer::Writer()
+		: head(NULL), tail(NULL), running(false)
+		{
+			#ifdef _WIN32
+			::InitializeCriticalSection( &mutex );
+			idle = ::CreateEvent( NULL, true, true, NULL );
+			#else
+			::pthread_mutex_init( &mutex, NULL );
+			::pthread_cond_init( &idle, NULL );
+			#endif
+		}
+
+		Machine::Writer::~Writer()
+		{
+			Wait();
+
+			#ifdef _WIN32
+			if (idle)
+				::CloseHandle( idle );
+
+			::DeleteCriticalSection( &mutex );
+			#else
+			::pthread_cond_destroy( &idle );
+			::pthread_mutex_destroy( &mutex );
+			#endif
+		}
+
+		void Machine::Writer::Lock()
+		{
+			#ifdef _WIN32
+			::EnterCriticalSection( &mutex );
+			#else
+			::pthread_mutex_lock( &mutex );
+			#endif
+		}
+
+		void Machine::Writer::Unlock()
+		{
+			#ifdef _WIN32
+			::LeaveCriticalSection( &mutex );
+			#else
+			::pthread_mutex_unlock( &mutex );
+			#endif
+		}
+
+		#ifdef _WIN32
+		DWORD WINAPI Machine::Writer::Run(LPVOID writer)
+		#else
+		void* Machine::Writer::Run(void* writer)
+		#endif
+		{
+			static_cast<Writer*>(writer)->Run();
+			return 0;
+		}
+
+		void Machine::Writer::Run()
+		{
+			for (;;)
+			{
+				Lock();
+
+				Job* const job = head;
+
+				if (job)
+				{
+					head = job->next;
+
+					if (!head)
+						tail = NULL;
+				}
+				else
+				{
+					running = false;
+
+					#ifdef _WIN32
+					::SetEvent( idle );
+					#else
+					::pthread_cond_broadcast( &idle );
+					#endif
+				}
+
+				Unlock();
+
+				if (!job)
+					break;
+
+				Write( *job );
+				delete job;
+			}
+		}
+
+		Result Machine::Writer::Save(Core::Machine& emulator,std::ostream& stream,uint compression)
+		{
+			Job* const job = new (std::nothrow) Job( stream, compression );
+
+			if (!job)
+				return RESULT_ERR_OUT_OF_MEMORY;
+
+			const Result result = emulator.SaveState( job->capture, false );
+
+			if (NES_FAILED(result))
+			{
+				delete job;
+				return result;
+			}
+
+			Lock();
+
+			if (tail)
+				tail->next = job;
+			else
+				head = job;
+
+			tail = job;
+
+			bool started = running;
+
+			if (!started)
+			{
+				#ifdef _WIN32
+				if (idle)
+				{
+					::ResetEvent( idle );
+
+					if (HANDLE const thread = ::CreateThread( NULL, 0, &Writer::Run, this, 0, NULL ))
+					{
+						::CloseHandle( thread );
+						started = true;
+					}
+					else
+					{
+						::SetEvent( idle );
+					}
+				}
+				#else
+				pthread_t thread;
+
+				if (!::pthread_create( &thread, NULL, &Writer::Run, this ))
+				{
+					::pthread_detach( thread );
+					started = true;
+				}
+				#endif
+
+				running = started;
+
+				if (!started)
+					head = tail = NULL;
+			}
+
+			Unlock();
+
+			// no thread to be had, with an empty queue
+			// behind it this one may just as well go now
+
+			if (!started)
+			{
+				Write( *job );
+				delete job;
+			}
+
+			return result;
+		}
+
+		void Machine::Writer::Wait()
+		{
+			#ifdef _WIN32
+			if (idle)
+				::WaitForSingleObject( idle, INFINITE );
+			#else
+			Lock();
+
+			while (running)
+				::pthread_cond_wait( &idle, &mutex );
+
+			Unlock();
+			#endif
+		}
+
+		#else
+
+		Machine::Writer::Writer()
+		{
+		}
+
+		Machine::Writer::~Writer()
+		{
+		}
+
+		Result Machine::Writer::Save(Core::Machine& emulator,std::ostream& stream,uint compression)
+		{
+			Job job( stream, compression );
+
+			const Result result = emulator.SaveState( job.capture, false );
+
+			if (NES_SUCCEEDED(result))
+				Write( job );
+
+			return result;
+		}
+
+		void Machine::Writer::Wait()
+		{
+		}
+
+		#endif
+
+		void Machine::Writer::Write(const Job& job)
+		{
+			Result result;
+
+			try
+			{
+				job.capture.Save( &job.stream, job.compression );
+				result = RESULT_OK;
+			}
+			catch (Result r)
+			{
+				result = r;
+			}
+			catch (const std::bad_alloc&)
+			{
+				result = RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				result = RESULT_ERR_GENERIC;
+			}
+
+			User::eventCallback( User::EVENT_STATE_SAVED, &result );
+		}
+
+		Result Machine::SaveStateAsync(std::ostream& stream,Compression compression) const throw()
+		{
+			return Writer::writer.Save( emulator, stream, compression );
+		}
+
+		void NST_CALL Machine::WaitForSavedStates() throw()
+		{
+			Writer::writer.Wait();
 		}
 
 		#ifdef NST_PRAGMA_OPTIMIZE
@@ -83,17 +83,40 @@ namespace Nes
 			enum Compression
 			{
 				NO_COMPRESSION,
-				USE_COMPRESSION
+				USE_COMPRESSION,
+				FAST_COMPRESSION
 			};
 
 			Result LoadState (std::istream&) throw();
 			Result SaveState (std::ostream&,Compression=USE_COMPRESSION) const throw();
+			Result LoadState (const void*,ulong) throw();
+			Result SaveState (void*,ulong&,Compression=USE_COMPRESSION) const throw();
+			Result SaveState (void*,ulong&,const void*,ulong) const throw();
+
+			static Result NST_CALL MaterializeState(const void*,ulong,const void*,ulong,void*,ulong&) throw();
+
+			// Takes the state right away and leaves compressing and writing it
+			// to another thread. The stream must be kept alive until its
+			// User::EVENT_STATE_SAVED comes from that thread with a pointer to
+			// the Result. States are written in the order they're handed over.
+
+			Result SaveStateAsync (std::ostream&,Compression=USE_COMPRESSION) const throw();
+
+			// Returns once all of the states above have been written.
+
+			static void NST_CALL WaitForSavedStates() throw();
 
 			uint Is (uint) const throw();
 			uint Is (uint,uint) const throw();
 
+			void EnableIdleLoopSkipping(bool=true) throw();
+			bool IsIdleLoopSkippingEnabled() const throw();
+			qword GetIdleLoopSkippedCycles() const throw();
+
 		private:
 
+			class Writer;
+
 			Result Load(std::istream&,uint);
 		};
 	}
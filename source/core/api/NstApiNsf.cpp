@@ -22,11 +22,28 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
 #include "../NstMachine.hpp"
 #include "../NstNsf.hpp"
+#include "NstApiEmulator.hpp"
 #include "NstApiMachine.hpp"
+#include "NstApiSound.hpp"
+#include "NstApiUser.hpp"
 #include "NstApiNsf.hpp"
 
+#ifndef NST_NO_THREADS
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
+
 #ifdef NST_PRAGMA_OPTIMIZE
 #pragma optimize("s", on)
 #endif
@@ -201,6 +218,309 @@ namespace Nes
 		{
 			return emulator.Is(Machine::SOUND) && static_cast<Core::Nsf*>(emulator.image)->UsesBankSwitching();
 		}
+
+		class Nsf::Batch
+		{
+		public:
+
+			Batch(const std::string& i,Track* t,uint c,ulong r)
+			: image(i), tracks(t), count(c), rate(r) {}
+
+			struct Share
+			{
+				const Batch* batch;
+				uint first;
+				uint step;
+			};
+
+			void Run(uint first,uint step) const
+			{
+				for (uint i=first; i < count; i += step)
+				{
+					try
+					{
+						tracks[i].result = Render( tracks[i] );
+					}
+					catch (const std::bad_alloc&)
+					{
+						tracks[i].result = RESULT_ERR_OUT_OF_MEMORY;
+					}
+					catch (...)
+					{
+						tracks[i].result = RESULT_ERR_GENERIC;
+					}
+				}
+			}
+
+			#ifndef NST_NO_THREADS
+
+			#ifdef _WIN32
+			static DWORD WINAPI Run(LPVOID share)
+			#else
+			static void* Run(void* share)
+			#endif
+			{
+				const Share& s = *static_cast<const Share*>(share);
+				s.batch->Run( s.first, s.step );
+				return 0;
+			}
+
+			// The log and event callbacks are shared by every emulator, for as
+			// long as the threads run they're swapped for ones that only let one
+			// of them through at a time. Samples go to a ring of each track's own
+			// so the sound output callbacks are never called.
+
+			class Callbacks
+			{
+			public:
+
+				Callbacks();
+				~Callbacks();
+
+			private:
+
+				void Lock();
+				void Unlock();
+
+				static void NST_CALLBACK Log(User::UserData,const char*,dword);
+				static void NST_CALLBACK Event(User::UserData,User::Event,const void*);
+
+				User::LogCallback logFunction;
+				User::UserData logData;
+				User::EventCallback eventFunction;
+				User::UserData eventData;
+
+				#ifdef _WIN32
+				CRITICAL_SECTION mutex;
+				#else
+				pthread_mutex_t mutex;
+				#endif
+			};
+
+			#endif
+
+		private:
+
+			Result Render(Track&) const;
+
+			const std::string& image;
+			Track* const tracks;
+			const uint count;
+			const ulong rate;
+		};
+
+		#ifndef NST_NO_THREADS
+
+		Nsf::Batch::Callbacks::Callbacks()
+		{
+			#ifdef _WIN32
+			::InitializeCriticalSection( &mutex );
+			#else
+			::pthread_mutex_init( &mutex, NULL );
+			#endif
+
+			User::logCallback.Get( logFunction, logData );
+			User::eventCallback.Get( eventFunction, eventData );
+
+			User::logCallback.Set( logFunction ? &Log : NULL, this );
+			User::eventCallback.Set( eventFunction ? &Event : NULL, this );
+		}
+
+		Nsf::Batch::Callbacks::~Callbacks()
+		{
+			User::logCallback.Set( logFunction, logData );
+			User::eventCallback.Set( eventFunction, eventData );
+
+			#ifdef _WIN32
+			::DeleteCriticalSection( &mutex );
+			#else
+			::pthread_mutex_destroy( &mutex );
+			#endif
+		}
+
+		void Nsf::Batch::Callbacks::Lock()
+		{
+			#ifdef _WIN32
+			::EnterCriticalSection( &mutex );
+			#else
+			::pthread_mutex_lock( &mutex );
+			#endif
+		}
+
+		void Nsf::Batch::Callbacks::Unlock()
+		{
+			#ifdef _WIN32
+			::LeaveCriticalSection( &mutex );
+			#else
+			::pthread_mutex_unlock( &mutex );
+			#endif
+		}
+
+		void NST_CALLBACK Nsf::Batch::Callbacks::Log(User::UserData data,const char* text,dword length)
+		{
+			Callbacks& callbacks = *static_cast<Callbacks*>(data);
+
+			callbacks.Lock();
+			callbacks.logFunction( callbacks.logData, text, length );
+			callbacks.Unlock();
+		}
+
+		void NST_CALLBACK Nsf::Batch::Callbacks::Event(User::UserData data,User::Event event,const void* context)
+		{
+			Callbacks& callbacks = *static_cast<Callbacks*>(data);
+
+			callbacks.Lock();
+			callbacks.eventFunction( callbacks.eventData, event, context );
+			callbacks.Unlock();
+		}
+
+		#endif
+
+		Result Nsf::Batch::Render(Track& track) const
+		{
+			Emulator emulator;
+
+			{
+				std::istringstream stream( image );
+
+				const Result result = Machine(emulator).LoadSound( stream );
+
+				if (NES_FAILED(result))
+					return result;
+			}
+
+			Sound sound( emulator );
+
+			Result result = sound.SetSampleRate( rate );
+
+			if (NES_SUCCEEDED(result) && NES_SUCCEEDED(result=sound.SetSampleBits( 16 )))
+				result = Machine(emulator).Power( true );
+
+			if (NES_SUCCEEDED(result))
+				result = Nsf(emulator).SelectSong( track.song );
+
+			if (NES_SUCCEEDED(result))
+				result = Nsf(emulator).PlaySong();
+
+			if (NES_FAILED(result))
+				return result;
+
+			// no video, and each frame's samples go out exactly as produced
+
+			i16 buffer[0x1000];
+			Core::Sound::Ring ring( buffer, 0x1000 );
+			Core::Sound::Output output;
+			output.ring = &ring;
+
+			i16* samples = static_cast<i16*>(track.samples);
+
+			for (ulong length=track.length; length; )
+			{
+				if (NES_FAILED(result=emulator.Execute( NULL, &output, NULL )))
+					return result;
+
+				const uint count = ring.Read( samples, NST_MIN(length,ring.Length()) );
+
+				if (!count)
+				{
+					std::memset( samples, 0, length * sizeof(i16) );
+					break;
+				}
+
+				samples += count;
+				length -= count;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result Nsf::Render(std::istream& stream,Track* const tracks,const uint count,const ulong rate,uint threads) throw()
+		{
+			if (!tracks || !count || !threads)
+				return RESULT_ERR_INVALID_PARAM;
+
+			try
+			{
+				const std::string image( (std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>() );
+				const Batch batch( image, tracks, count, rate );
+
+				threads = NST_MIN(threads,count);
+
+				#ifndef NST_NO_THREADS
+
+				// every thread takes every n'th track, the calling one included
+
+				std::vector<Batch::Share> shares( threads );
+
+				#ifdef _WIN32
+				std::vector<HANDLE> workers;
+				#else
+				std::vector<pthread_t> workers;
+				#endif
+
+				workers.reserve( threads );
+
+				Batch::Callbacks callbacks;
+
+				for (uint i=1; i < threads; ++i)
+				{
+					shares[i].batch = &batch;
+					shares[i].first = i;
+					shares[i].step = threads;
+
+					#ifdef _WIN32
+					if (HANDLE worker = ::CreateThread( NULL, 0, &Batch::Run, &shares[i], 0, NULL ))
+						workers.push_back( worker );
+					#else
+					pthread_t worker;
+
+					if (!::pthread_create( &worker, NULL, &Batch::Run, &shares[i] ))
+						workers.push_back( worker );
+					#endif
+					else
+						break;
+				}
+
+				// shares of threads that couldn't be started are done here
+
+				for (uint i=workers.size()+1; i < threads; ++i)
+					batch.Run( i, threads );
+
+				batch.Run( 0, threads );
+
+				for (uint i=0; i < workers.size(); ++i)
+				{
+					#ifdef _WIN32
+					::WaitForSingleObject( workers[i], INFINITE );
+					::CloseHandle( workers[i] );
+					#else
+					::pthread_join( workers[i], NULL );
+					#endif
+				}
+
+				#else
+
+				batch.Run( 0, 1 );
+
+				#endif
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			for (uint i=0; i < count; ++i)
+			{
+				if (NES_FAILED(tracks[i].result))
+					return tracks[i].result;
+			}
+
+			return RESULT_OK;
+		}
 	}
 }
 
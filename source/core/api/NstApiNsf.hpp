@@ -29,6 +29,7 @@
 #pragma once
 #endif
 
+#include <iosfwd>
 #include "NstApi.hpp"
 
 #ifdef _MSC_VER
@@ -90,6 +91,29 @@ namespace Nes
 			Result SelectPrevSong() throw();
 			Result PlaySong() throw();
 			Result StopSong() throw();
+
+			struct Track
+			{
+				Track(uint s=0,ulong l=0,void* p=NULL)
+				: song(s), length(l), samples(p), result(RESULT_NOP) {}
+
+				uint song;
+				ulong length;
+				void* samples;
+				Result result;
+			};
+
+			// Renders each track's song to 16 bit mono samples in an emulator
+			// instance of its own, spread over the given number of threads.
+			// The User log and event callbacks will be called from those
+			// threads, though never from two of them at once, and must not
+			// be changed before this returns.
+
+			static Result Render(std::istream&,Track*,uint,ulong,uint) throw();
+
+		private:
+
+			class Batch;
 		};
 	}
 }
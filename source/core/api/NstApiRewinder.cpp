@@ -72,6 +72,34 @@ namespace Nes
 			emulator.tracker.RewinderEnableSound( enable );
 		}
 
+		Result Rewinder::SetMemoryBudget(ulong budget) throw()
+		{
+			if (budget < MIN_MEMORY_BUDGET || budget > 0xFFFFFFFFUL)
+				return RESULT_ERR_INVALID_PARAM;
+
+			try
+			{
+				return emulator.tracker.RewinderSetMemoryBudget( budget );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+		}
+
+		ulong Rewinder::GetMemoryBudget() const throw()
+		{
+			return emulator.tracker.RewinderGetMemoryBudget();
+		}
+
 		Rewinder::Direction Rewinder::GetDirection() const throw()
 		{
 			return emulator.tracker.IsRewinding() ? BACKWARD : FORWARD;
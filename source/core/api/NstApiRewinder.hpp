@@ -63,6 +63,15 @@ namespace Nes
 			void EnableSound(bool=true) throw();
 			bool IsSoundEnabled() const throw();
 
+			enum
+			{
+				DEFAULT_MEMORY_BUDGET = 0x2000000,
+				MIN_MEMORY_BUDGET = 0x40000
+			};
+
+			Result SetMemoryBudget(ulong) throw();
+			ulong GetMemoryBudget() const throw();
+
 			Result SetDirection(Direction) throw();
 			Direction GetDirection() const throw();
 
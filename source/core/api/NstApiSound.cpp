@@ -22,9 +22,20 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
+#include <cstring>
 #include "../NstMachine.hpp"
 #include "NstApiSound.hpp"
 
+#if defined(__GNUC__)
+#define NST_RING_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && _MSC_VER >= 1400
+#include <intrin.h>
+#define NST_RING_BARRIER() _ReadWriteBarrier()
+#else
+#define NST_RING_BARRIER() NST_NOP
+#endif
+
 #ifdef NST_PRAGMA_OPTIMIZE
 #pragma optimize("s", on)
 #endif
@@ -38,6 +49,100 @@ namespace Nes
 			Output::Locker Output::lockCallback;
 			Output::Unlocker Output::unlockCallback;
 			Loader::Callbacker Loader::loadCallback;
+
+			static uint FloorPow2(uint n)
+			{
+				while (n & (n-1))
+					n &= n-1;
+
+				return n;
+			}
+
+			Ring::Ring(void* samples,uint n,uint b,bool s)
+			:
+			data   (static_cast<char*>(samples)),
+			length (samples ? FloorPow2(n) : 0),
+			bits   (b),
+			stereo (s),
+			shift  ((b >> 4) + uint(s)),
+			head   (0),
+			tail   (0)
+			{}
+
+			uint Ring::Fill() const throw()
+			{
+				const uint fill = head - tail;
+
+				// nothing past the head may be read before the head itself
+				NST_RING_BARRIER();
+
+				return fill;
+			}
+
+			uint Ring::Space() const throw()
+			{
+				const uint fill = head - tail;
+
+				// nor written over before the consumer is done with it
+				NST_RING_BARRIER();
+
+				return length - fill;
+			}
+
+			long Ring::GetRateAdjustment(const long limit) const throw()
+			{
+				// Scales linearly from +limit on an empty ring to -limit on a
+				// full one, settling the producer around the half-way mark.
+
+				return limit * (long(length) - long(Fill()) * 2) / long(length);
+			}
+
+			uint Ring::Read(void* const samples,uint count) throw()
+			{
+				count = NST_MIN(count,Fill());
+
+				if (count)
+				{
+					const uint pos = tail & (length-1);
+					const uint chunk = NST_MIN(count,length-pos);
+
+					std::memcpy( samples, data + (pos << shift), chunk << shift );
+					std::memcpy( static_cast<char*>(samples) + (chunk << shift), data, (count - chunk) << shift );
+
+					NST_RING_BARRIER();
+
+					tail = tail + count;
+				}
+
+				return count;
+			}
+
+			bool Ring::Reserve(Output& output,uint count,const uint b,const bool s) throw()
+			{
+				// the byte shift alone can't tell 16 bit mono from 8 bit stereo
+
+				if (bits != b || stereo != s)
+					return false;
+
+				count = NST_MIN(count,Space());
+
+				const uint pos = head & (length-1);
+
+				output.samples[0] = data + (pos << shift);
+				output.length[0] = NST_MIN(count,length-pos);
+				output.samples[1] = data;
+				output.length[1] = count - output.length[0];
+
+				return count;
+			}
+
+			void Ring::Commit(const Output& output) throw()
+			{
+				// the samples must be in place before they're handed over
+				NST_RING_BARRIER();
+
+				head = head + output.length[0] + output.length[1];
+			}
 		}
 	}
 
@@ -52,6 +157,8 @@ namespace Nes
 			Sound::CHANNEL_DPCM     == 1U << Core::Apu::CHANNEL_DPCM
 		);
 
+		NST_COMPILE_ASSERT( uint(Sound::Output::NUM_STEMS) == uint(Core::Apu::MAX_CHANNELS) );
+
 		Result Sound::SetSampleRate(ulong rate) throw()
 		{
 			return emulator.cpu.GetApu().SetSampleRate( rate );
@@ -77,6 +184,33 @@ namespace Nes
 			emulator.cpu.GetApu().SetAutoTranspose( enable );
 		}
 
+		Result Sound::SetBandLimiting(bool enable) throw()
+		{
+			try
+			{
+				return emulator.cpu.GetApu().SetBandLimiting( enable );
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+		}
+
+		void Sound::SetStemOutput(bool enable) throw()
+		{
+			emulator.cpu.GetApu().SetStemOutput( enable );
+		}
+
+		void Sound::SetRateControl(bool enable) throw()
+		{
+			emulator.cpu.GetApu().SetRateControl( enable );
+		}
+
+		Result Sound::SetRateAdjustment(long ppm) throw()
+		{
+			return emulator.cpu.GetApu().SetRateAdjustment( ppm );
+		}
+
 		void Sound::SetSpeaker(Speaker speaker) throw()
 		{
 			return emulator.cpu.GetApu().EnableStereo( speaker == SPEAKER_STEREO );
@@ -112,6 +246,26 @@ namespace Nes
 			return emulator.cpu.GetApu().IsAutoTransposing();
 		}
 
+		bool Sound::IsBandLimiting() const throw()
+		{
+			return emulator.cpu.GetApu().IsBandLimiting();
+		}
+
+		bool Sound::IsStemOutput() const throw()
+		{
+			return emulator.cpu.GetApu().IsStemOutput();
+		}
+
+		bool Sound::IsRateControlled() const throw()
+		{
+			return emulator.cpu.GetApu().IsRateControlled();
+		}
+
+		long Sound::GetRateAdjustment() const throw()
+		{
+			return emulator.cpu.GetApu().GetRateAdjustment();
+		}
+
 		Sound::Speaker Sound::GetSpeaker() const throw()
 		{
 			return emulator.cpu.GetApu().InStereo() ? SPEAKER_STEREO : SPEAKER_MONO;
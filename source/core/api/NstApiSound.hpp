@@ -42,6 +42,50 @@ namespace Nes
 	{
 		namespace Sound
 		{
+			class Output;
+
+			class Ring
+			{
+			public:
+
+				Ring(void*,uint,uint=16,bool=false);
+
+				uint Read(void*,uint) throw();
+				uint Fill() const throw();
+				uint Space() const throw();
+				long GetRateAdjustment(long) const throw();
+
+				bool Reserve(Output&,uint,uint,bool) throw();
+				void Commit(const Output&) throw();
+
+			private:
+
+				enum
+				{
+					CACHE_LINE = 64
+				};
+
+				char* const data;
+				const uint length;
+				const uint bits;
+				const bool stereo;
+				const uint shift;
+
+				// the producer only writes head, the consumer only tail,
+				// kept on separate cache lines so they don't bounce around
+
+				volatile uint head;
+				char pad[CACHE_LINE];
+				volatile uint tail;
+
+			public:
+
+				uint Length() const
+				{
+					return length;
+				}
+			};
+
 			class Output
 			{
 				struct Locker;
@@ -51,18 +95,39 @@ namespace Nes
 
 				enum
 				{
-					MAX_LENGTH = 0x8000U
+					MAX_LENGTH = 0x8000U,
+					NUM_STEMS = 11
 				};
 
 				void* samples[2];
 				uint length[2];
 
+				// stem output, one 16 bit mono block per channel bit position,
+				// stemCount is set to the number of samples written to each
+
+				i16* stems[NUM_STEMS];
+				uint stemLength;
+				uint stemCount;
+
+				// set to have each frame's samples queued up for another thread
+				// to pick up, in place of the samples above and the callbacks
+
+				Ring* ring;
+
 				Output(void* s0=NULL,uint l0=0,void* s1=NULL,uint l1=0)
+				:
+				ring (NULL)
 				{
 					samples[0] = s0;
 					samples[1] = s1;
 					length[0] = l0;
 					length[1] = l1;
+
+					for (uint i=0; i < NUM_STEMS; ++i)
+						stems[i] = NULL;
+
+					stemLength = 0;
+					stemCount = 0;
 				}
 
 				typedef bool (NST_CALLBACK *LockCallback) (void*,Output&);
@@ -177,7 +242,8 @@ namespace Nes
 				MAX_VOLUME = 100,
 				DEFAULT_SPEED = 0,
 				MIN_SPEED = 30,
-				MAX_SPEED = 240
+				MAX_SPEED = 240,
+				MAX_RATE_ADJUSTMENT = 5000
 			};
 
 			Result  SetSampleRate(ulong) throw();
@@ -185,18 +251,27 @@ namespace Nes
 			Result  SetVolume(uint,uint) throw();
 			Result  SetSpeed(uint) throw();
 			void    SetAutoTranspose(bool) throw();
+			Result  SetBandLimiting(bool) throw();
+			void    SetStemOutput(bool) throw();
+			void    SetRateControl(bool) throw();
+			Result  SetRateAdjustment(long) throw();
 			void    SetSpeaker(Speaker) throw();
 			bool    IsAutoTransposing() const throw();
+			bool    IsBandLimiting() const throw();
+			bool    IsStemOutput() const throw();
+			bool    IsRateControlled() const throw();
 			bool    IsAudible() const throw();
 			ulong   GetSampleRate() const throw();
 			uint    GetSampleBits() const throw();
 			uint    GetVolume(uint) const throw();
 			uint    GetSpeed() const throw();
+			long    GetRateAdjustment() const throw();
 			uint    GetLatency() const throw();
 			Speaker GetSpeaker() const throw();
 			void    EmptyBuffer() throw();
 
 			typedef Core::Sound::Output Output;
+			typedef Core::Sound::Ring Ring;
 			typedef Core::Sound::Loader Loader;
 		};
 	}
@@ -80,7 +80,8 @@ namespace Nes
 				EVENT_TAPE_PLAYING,
 				EVENT_TAPE_RECORDING,
 				EVENT_TAPE_STOPPED,
-				EVENT_NONSTANDARD_DISK
+				EVENT_NONSTANDARD_DISK,
+				EVENT_STATE_SAVED
 			};
 
 			enum File
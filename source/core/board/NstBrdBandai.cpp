@@ -1069,6 +1069,11 @@ namespace Nes
 				return count == 0;
 			}
 
+			dword Bandai::Irq::NextSignal() const
+			{
+				return ((count - 1) & 0xFFFFU) + 1;
+			}
+
 			void Bandai::VSync()
 			{
 				irq.VSync();
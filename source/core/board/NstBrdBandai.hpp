@@ -79,6 +79,7 @@ namespace Nes
 				{
 					void Reset(bool);
 					ibool Signal();
+					dword NextSignal() const;
 
 					uint count;
 					uint latch;
@@ -191,6 +191,11 @@ namespace Nes
 				return false;
 			}
 
+			dword Ffe::Irq::NextSignal() const
+			{
+				return enabled ? dword(clock - count) + 1 : 0;
+			}
+
 			NES_POKE(Ffe,42FE)
 			{
 				mode = data >> 7 ^ 0x1;
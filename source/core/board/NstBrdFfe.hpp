@@ -81,6 +81,7 @@ namespace Nes
 				{
 					void Reset(bool);
 					ibool Signal();
+					dword NextSignal() const;
 
 					uint count;
 					ibool enabled;
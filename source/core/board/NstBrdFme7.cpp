@@ -740,6 +740,11 @@ namespace Nes
 				return count < enabled;
 			}
 
+			dword Fme7::Irq::NextSignal() const
+			{
+				return enabled ? ((count - 1) & 0xFFFFU) + 1 : 0;
+			}
+
 			NST_FORCE_INLINE dword Fme7::Sound::Envelope::Clock(const Cycle rate)
 			{
 				if (!holding)
@@ -852,6 +857,19 @@ namespace Nes
 				}
 			}
 
+			Fme7::Sound::Sample Fme7::Sound::GetStems(Sample (&stems)[MAX_CHANNELS])
+			{
+				return stems[Apu::CHANNEL_S5B] = GetSample();
+			}
+
+			Cycle Fme7::Sound::Render(Sample* const output,const uint length,Cycle,Cycle,const Cycle next)
+			{
+				for (uint i=0; i < length; ++i)
+					output[i] = Sound::GetSample();
+
+				return next;
+			}
+
 			void Fme7::VSync()
 			{
 				irq.VSync();
@@ -56,6 +56,8 @@ namespace Nes
 					void Reset();
 					void UpdateContext(uint,const u8 (&)[MAX_CHANNELS]);
 					Sample GetSample();
+					Sample GetStems(Sample (&)[MAX_CHANNELS]);
+					Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				private:
 
@@ -201,6 +203,7 @@ namespace Nes
 				{
 					void Reset(bool);
 					ibool Signal();
+					dword NextSignal() const;
 
 					uint count;
 					ibool enabled;
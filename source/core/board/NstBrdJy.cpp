@@ -164,6 +164,11 @@ namespace Nes
 				ppu.SetBgHook( Hook(this,&Jy::Hook_PpuBg) );
 				ppu.SetSpHook( Hook(this,&Jy::Hook_PpuSp) );
 
+				// the ppu read counter is clocked from the hooks above
+				// relative to the cpu, both have to stay in step
+
+				ppu.EnableCpuSynchronization();
+
 				if (cartSwitches.IsPpuLatched())
 				{
 					chr.SetAccessor( 0, this, &Jy::Access_Chr_0000 );
@@ -434,16 +439,34 @@ namespace Nes
 					return (++prescaler & scale) == 0x00 && (++count & 0xFF) == 0x00;
 			}
 
+			dword Jy::Irq::NextSignal() const
+			{
+				if (mode & MODE_COUNT_DOWN)
+					return (prescaler & scale) + 1 + (count & 0xFF) * (scale + 1);
+				else
+					return (scale + 1) - (prescaler & scale) + (0xFF - (count & 0xFF)) * (scale + 1);
+			}
+
 			ibool Jy::Irq::A12::Signal()
 			{
 				return base.IsEnabled(MODE_PPU_A12) && base.Signal();
 			}
 
+			dword Jy::Irq::A12::NextSignal() const
+			{
+				return base.IsEnabled(MODE_PPU_A12) ? base.NextSignal() : 0;
+			}
+
 			ibool Jy::Irq::M2::Signal()
 			{
 				return base.IsEnabled(MODE_M2) && base.Signal();
 			}
 
+			dword Jy::Irq::M2::NextSignal() const
+			{
+				return base.IsEnabled(MODE_M2) ? base.NextSignal() : 0;
+			}
+
 			uint Jy::Banks::Unscramble(const uint bank)
 			{
 				return
@@ -186,6 +186,7 @@ namespace Nes
 
 						void Reset(bool);
 						ibool Signal();
+						dword NextSignal() const;
 
 						Irq& base;
 					};
@@ -196,6 +197,7 @@ namespace Nes
 
 						void Reset(bool);
 						ibool Signal();
+						dword NextSignal() const;
 
 						Irq& base;
 					};
@@ -206,6 +208,7 @@ namespace Nes
 					ibool IsEnabled() const;
 					ibool IsEnabled(uint) const;
 					ibool Signal();
+					dword NextSignal() const;
 					inline void Update();
 
 					enum
@@ -77,6 +77,16 @@ namespace Nes
 						return (tmp | persistant) && !count && enabled;
 					}
 
+					dword NextSignal() const
+					{
+						if (!enabled)
+							return 0;
+						else if (!count || reload)
+							return latch + 1;
+						else
+							return count;
+					}
+
 					void SetLatch(uint data)
 					{
 						latch = data;
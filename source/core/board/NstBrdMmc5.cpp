@@ -1660,6 +1660,26 @@ namespace Nes
 				}
 			}
 
+			Mmc5::Sound::Sample Mmc5::Sound::GetStems(Sample (&stems)[MAX_CHANNELS])
+			{
+				return stems[Apu::CHANNEL_MMC5] = GetSample();
+			}
+
+			Cycle Mmc5::Sound::Render(Sample* const output,const uint length,Cycle clock,const Cycle period,Cycle next)
+			{
+				for (uint i=0; i < length; ++i)
+				{
+					output[i] = Sound::GetSample();
+
+					while (next <= clock)
+						next += Sound::Clock();
+
+					clock += period;
+				}
+
+				return next;
+			}
+
 			NST_FORCE_INLINE void Mmc5::Sound::Square::ClockQuarter()
 			{
 				envelope.Clock();
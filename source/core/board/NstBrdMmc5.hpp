@@ -55,6 +55,8 @@ namespace Nes
 					void UpdateContext(uint,const u8 (&w)[MAX_CHANNELS]);
 					Cycle Clock();
 					Sample GetSample();
+					Sample GetStems(Sample (&)[MAX_CHANNELS]);
+					Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				private:
 
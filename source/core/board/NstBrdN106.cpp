@@ -43,6 +43,7 @@ namespace Nes
 				{
 					void Reset(bool);
 					ibool Signal();
+					dword NextSignal() const;
 
 					uint count;
 				};
@@ -276,6 +277,11 @@ namespace Nes
 				return (count - 0x8000U < 0x7FFFU) && (++count == 0xFFFFU);
 			}
 
+			dword N106::Chips::Irq::NextSignal() const
+			{
+				return (count - 0x8000U < 0x7FFFU) ? 0xFFFFU - count : 0;
+			}
+
 			inline bool N106::Sound::BaseChannel::CanOutput() const
 			{
 				return volume && frequency && enabled;
@@ -351,6 +357,75 @@ namespace Nes
 				}
 			}
 
+			N106::Sound::Sample N106::Sound::GetStems(Sample (&stems)[MAX_CHANNELS])
+			{
+				return stems[Apu::CHANNEL_N106] = GetSample();
+			}
+
+			inline void N106::Sound::BaseChannel::Render
+			(
+				Sample* const output,
+				const uint length,
+				const Cycle rate,
+				const Cycle factor,
+				const u8 (&wave)[0x100]
+			)
+			{
+				NST_VERIFY( bool(active) == CanOutput() );
+
+				if (active && length)
+				{
+					output[0] += GetSample( rate, factor, wave );
+
+					// From here on the timer stays below the factor and the phase
+					// below the wave length, so the divisions of GetSample() come
+					// down to a carry and a wrap around.
+
+					const Cycle whole = rate / factor;
+					const Cycle rest = rate % factor;
+
+					const dword steps[2] =
+					{
+						whole * frequency % waveLength,
+						(whole + 1) * frequency % waveLength
+					};
+
+					for (uint i=1; i < length; ++i)
+					{
+						timer += rest;
+
+						const uint carry = (timer >= factor);
+
+						if (carry)
+							timer -= factor;
+
+						phase += steps[carry];
+
+						if (phase >= waveLength)
+							phase -= waveLength;
+
+						output[i] += wave[(waveOffset + (phase >> PHASE_SHIFT)) & 0xFF] * volume;
+					}
+				}
+			}
+
+			Cycle N106::Sound::Render(Sample* const output,const uint length,Cycle,Cycle,const Cycle next)
+			{
+				for (uint i=0; i < length; ++i)
+					output[i] = 0;
+
+				if (outputVolume)
+				{
+					for (BaseChannel* channel = channels+startChannel; channel != channels+NUM_CHANNELS; ++channel)
+						channel->Render( output, length, rate, frequency, wave );
+
+					for (uint i=0; i < length; ++i)
+						output[i] = dcBlocker.Apply( dword(output[i]) * outputVolume / DEFAULT_VOLUME );
+				}
+
+				return next;
+			}
+
 			void N106::Sound::UpdateContext(uint,const u8 (&volumes)[MAX_CHANNELS])
 			{
 				outputVolume = volumes[Apu::CHANNEL_N106] * 68 / DEFAULT_VOLUME;
@@ -58,6 +58,8 @@ namespace Nes
 					void Reset();
 					void UpdateContext(Cycle,const u8 (&w)[MAX_CHANNELS]);
 					Sample GetSample();
+					Sample GetStems(Sample (&)[MAX_CHANNELS]);
+					Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				private:
 
@@ -84,6 +86,7 @@ namespace Nes
 						void Reset();
 
 						inline dword GetSample(Cycle,Cycle,const u8 (&)[0x100]);
+						inline void Render(Sample*,uint,Cycle,Cycle,const u8 (&)[0x100]);
 
 						inline void SetFrequency  (uint);
 						inline void SetWaveLength (uint);
@@ -398,6 +398,18 @@ namespace Nes
 				return false;
 			}
 
+			dword Vrc4::BaseIrq::NextSignal() const
+			{
+				const dword steps = 0x100 - (count[1] & 0xFF);
+
+				if (ctrl & NO_PPU_SYNC)
+					return steps;
+
+				// prescaler gains 3 per clock and ticks the counter every 341
+
+				return (steps * 341 - count[0] + 2) / 3;
+			}
+
 			void Vrc4::VSync()
 			{
 				if (irq)
@@ -41,6 +41,7 @@ namespace Nes
 				{
 					void Reset(bool);
 					ibool Signal();
+					dword NextSignal() const;
 
 					enum
 					{
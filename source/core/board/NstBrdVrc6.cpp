@@ -505,6 +505,38 @@ namespace Nes
 				}
 			}
 
+			Vrc6::Sound::Sample Vrc6::Sound::GetStems(Sample (&stems)[MAX_CHANNELS])
+			{
+				return stems[Apu::CHANNEL_VRC6] = GetSample();
+			}
+
+			Cycle Vrc6::Sound::Render(Sample* const output,const uint length,Cycle,Cycle,const Cycle next)
+			{
+				if (outputVolume)
+				{
+					// one channel at a time through the whole block
+
+					for (uint i=0; i < length; ++i)
+						output[i] = square[0].GetSample( rate );
+
+					for (uint i=0; i < length; ++i)
+						output[i] += square[1].GetSample( rate );
+
+					for (uint i=0; i < length; ++i)
+						output[i] += saw.GetSample( rate );
+
+					for (uint i=0; i < length; ++i)
+						output[i] = dcBlocker.Apply( dword(output[i]) * outputVolume / DEFAULT_VOLUME );
+				}
+				else
+				{
+					for (uint i=0; i < length; ++i)
+						output[i] = 0;
+				}
+
+				return next;
+			}
+
 			NES_POKE(Vrc6,B003)
 			{
 				SetMirroringVH01( data >> 2 );
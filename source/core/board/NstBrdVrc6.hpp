@@ -63,6 +63,8 @@ namespace Nes
 					void Reset();
 					void UpdateContext(uint,const u8 (&w)[MAX_CHANNELS]);
 					Sample GetSample();
+					Sample GetStems(Sample (&)[MAX_CHANNELS]);
+					Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				private:
 
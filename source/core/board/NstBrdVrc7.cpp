@@ -31,6 +31,11 @@
 #include "NstBrdVrc4.hpp"
 #include "NstBrdVrc7.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NST_VRC7_SSE2
+#include <emmintrin.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////
 //
 // VRC7 Sound Reference:
@@ -214,6 +219,7 @@ namespace Nes
 			}
 
 			Vrc7::Sound::OpllChannel::OpllChannel()
+			: operators(NULL), op(0)
 			{
 				Reset();
 			}
@@ -221,6 +227,11 @@ namespace Nes
 			Vrc7::Sound::Sound(Cpu& cpu,bool hook)
 			: apu(cpu.GetApu()), hooked(hook)
 			{
+				operators.Reset();
+
+				for (uint i=0; i < NUM_OPLL_CHANNELS; ++i)
+					channels[i].Connect( operators, i );
+
 				if (hook)
 					apu.HookChannel( this );
 			}
@@ -276,6 +287,30 @@ namespace Nes
 				}
 			}
 
+			void Vrc7::Sound::Operators::Reset()
+			{
+				for (uint i=0; i < NUM_OPERATORS; ++i)
+				{
+					pgCounter[i] = 0;
+					pgPhase[i] = 0;
+					pgVibrato[i] = 0;
+					egCounter[i] = EG_BEGIN;
+					egPhase[i] = 0;
+					egLimit[i] = EG_NEVER;
+					egAttack[i] = 0;
+					egSilent[i] = ~u32(0);
+					egOut[i] = 0;
+					tl[i] = 0;
+					am[i] = 0;
+				}
+			}
+
+			void Vrc7::Sound::OpllChannel::Connect(Operators& o,uint i)
+			{
+				operators = &o;
+				op = i * NUM_SLOTS;
+			}
+
 			void Vrc7::Sound::OpllChannel::Reset()
 			{
 				frequency = 0;
@@ -291,12 +326,7 @@ namespace Nes
 
 				for (uint i=0; i < NUM_SLOTS; ++i)
 				{
-					slots[i].pg.phase = 0;
-					slots[i].pg.counter = 0;
 					slots[i].eg.mode = EG_SETTLE;
-					slots[i].eg.counter = EG_BEGIN;
-					slots[i].eg.phase = 0;
-					slots[i].tl = 0;
 					slots[i].sl = 0;
 					slots[i].output = 0;
 				}
@@ -305,6 +335,7 @@ namespace Nes
 			void Vrc7::Sound::Reset()
 			{
 				ResetClock();
+				operators.Reset();
 
 				for (uint i=0; i < NUM_OPLL_CHANNELS; ++i)
 					channels[i].Reset();
@@ -570,52 +601,89 @@ namespace Nes
 
 			void Vrc7::Sound::OpllChannel::UpdateEgPhase(const Tables& tables,const uint i)
 			{
-				NST_ASSERT( i < NUM_SLOTS );
+				NST_ASSERT( i < NUM_SLOTS && operators );
+
+				dword phase = 0;
+				dword limit = Operators::EG_NEVER;
 
 				switch (slots[i].eg.mode)
 				{
 					case EG_ATTACK:
 
-						slots[i].eg.phase = tables.GetAttack( patch.tone[4+i] >> 4, slots[i].sl );
+						phase = tables.GetAttack( patch.tone[4+i] >> 4, slots[i].sl );
+						limit = ((patch.tone[4+i] & REG45_ATTACK) == REG45_ATTACK) ? 0 : EG_BEGIN;
 						break;
 
 					case EG_DECAY:
 
-						slots[i].eg.phase = tables.GetDecay( patch.tone[4+i] & REG45_DECAY, slots[i].sl );
+						phase = tables.GetDecay( patch.tone[4+i] & REG45_DECAY, slots[i].sl );
+						limit = GetSustainLevel( i );
+						break;
+
+					case EG_HOLD:
+
+						if (!(patch.tone[0+i] & REG01_HOLD))
+							limit = 0;
+
 						break;
 
 					case EG_SUSTAIN:
 
-						slots[i].eg.phase = tables.GetSustain( patch.tone[6+i] & REG67_RELEASE, slots[i].sl );
+						phase = tables.GetSustain( patch.tone[6+i] & REG67_RELEASE, slots[i].sl );
+						limit = EG_BEGIN + phase;
 						break;
 
 					case EG_RELEASE:
 
 						if (i != MODULATOR && sustain)
 						{
-							slots[i].eg.phase = tables.GetRelease( 5, slots[i].sl );
+							phase = tables.GetRelease( 5, slots[i].sl );
 						}
 						else if (patch.tone[0+i] & REG01_HOLD)
 						{
-							slots[i].eg.phase = tables.GetRelease( patch.tone[6+i] & REG67_RELEASE, slots[i].sl );
+							phase = tables.GetRelease( patch.tone[6+i] & REG67_RELEASE, slots[i].sl );
 						}
 						else
 						{
-							slots[i].eg.phase = tables.GetRelease( 7, slots[i].sl );
+							phase = tables.GetRelease( 7, slots[i].sl );
 						}
+
+						limit = EG_BEGIN + phase;
 						break;
 
-					default:
+					case EG_SETTLE:
+					case EG_FINISH:
 
-						slots[i].eg.phase = 0;
 						break;
 				}
+
+				// the clock steps every counter by its phase and hands any that reach
+				// their limit back to UpdateEgMode(), so a limit of zero fires on the
+				// next clock and EG_NEVER doesn't fire at all
+
+				operators->egPhase[op+i] = phase;
+				operators->egLimit[op+i] = limit;
+				operators->egAttack[op+i] = (slots[i].eg.mode == EG_ATTACK) ? ~u32(0) : 0;
+				operators->egSilent[op+i] = (slots[i].eg.mode == EG_SETTLE || slots[i].eg.mode == EG_FINISH) ? ~u32(0) : 0;
+			}
+
+			dword Vrc7::Sound::OpllChannel::GetSustainLevel(const uint i) const
+			{
+				dword level = patch.tone[6+i] & REG67_SUSTAIN_LEVEL;
+
+				if (level == REG67_SUSTAIN_LEVEL)
+					level = SUSTAIN_LEVEL_MAX;
+
+				return level << (EG_PHASE_SHIFT-1);
 			}
 
 			void Vrc7::Sound::OpllChannel::UpdatePhase(const Tables& tables,const uint i)
 			{
-				NST_ASSERT( i < NUM_SLOTS );
-				slots[i].pg.phase = tables.GetPhase( frequency, block, patch.tone[0+i] & REG01_MULTIPLE );
+				NST_ASSERT( i < NUM_SLOTS && operators );
+
+				operators->pgPhase[op+i] = tables.GetPhase( frequency, block, patch.tone[0+i] & REG01_MULTIPLE );
+				operators->pgVibrato[op+i] = (patch.tone[0+i] & REG01_USE_VIBRATO) ? ~u32(0) : 0;
+				operators->am[op+i] = (patch.tone[0+i] & REG01_USE_AMP) ? ~u32(0) : 0;
 			}
 
 			void Vrc7::Sound::OpllChannel::UpdateSustainLevel(const Tables& tables,const uint i)
@@ -627,7 +695,7 @@ namespace Nes
 			void Vrc7::Sound::OpllChannel::UpdateTotalLevel(const Tables& tables,const uint i)
 			{
 				NST_ASSERT( i < NUM_SLOTS );
-				slots[i].tl = tables.GetTotalLevel( frequency, block, (i != MODULATOR) ? volume : (patch.tone[2] & REG2_TOTAL_LEVEL), patch.tone[2+i] >> 6 );
+				operators->tl[op+i] = tables.GetTotalLevel( frequency, block, (i != MODULATOR) ? volume : (patch.tone[2] & REG2_TOTAL_LEVEL), patch.tone[2+i] >> 6 );
 			}
 
 			void Vrc7::Sound::OpllChannel::Update(const Tables& tables)
@@ -751,14 +819,14 @@ namespace Nes
 						for (uint i=0; i < NUM_SLOTS; ++i)
 						{
 							slots[i].eg.mode = EG_ATTACK;
-							slots[i].eg.counter = 0;
-							slots[i].pg.counter = 0;
+							operators->egCounter[op+i] = 0;
+							operators->pgCounter[op+i] = 0;
 						}
 					}
 					else
 					{
 						if (slots[CARRIER].eg.mode == EG_ATTACK)
-							slots[CARRIER].eg.counter = tables.GetLog( slots[CARRIER].eg.counter >> EG_PHASE_SHIFT ) << EG_PHASE_SHIFT;
+							operators->egCounter[op+CARRIER] = tables.GetLog( operators->egCounter[op+CARRIER] >> EG_PHASE_SHIFT ) << EG_PHASE_SHIFT;
 
 						slots[CARRIER].eg.mode = EG_RELEASE;
 					}
@@ -873,90 +941,142 @@ namespace Nes
 				}
 			}
 
-			NST_FORCE_INLINE Vrc7::Sound::Sample Vrc7::Sound::OpllChannel::GetSample(const uint pitch,const uint amp,const Tables& tables)
+			inline uint Vrc7::Sound::Operators::Clock(const uint pitch,uint& attacking)
 			{
-				uint pgOut[NUM_SLOTS], egOut[NUM_SLOTS];
+				uint events = 0;
+				attacking = 0;
 
-				for (uint i=0; i < NUM_SLOTS; ++i)
-				{
-					if (patch.tone[i] & REG01_USE_VIBRATO)
-						slots[i].pg.counter += (slots[i].pg.phase * pitch) >> AMP_SHIFT;
-					else
-						slots[i].pg.counter += slots[i].pg.phase;
+			#ifdef NST_VRC7_SSE2
 
-					slots[i].pg.counter &= PG_PHASE_RANGE;
-					pgOut[i] = slots[i].pg.counter >> PG_PHASE_SHIFT;
-					egOut[i] = slots[i].eg.counter >> EG_PHASE_SHIFT;
+				const __m128i multiplier = _mm_set1_epi32( pitch );
+				const __m128i range = _mm_set1_epi32( PG_PHASE_RANGE );
+				const __m128i end = _mm_set1_epi32( EG_END );
+				const __m128i one = _mm_set1_epi32( 1 );
 
-					switch (slots[i].eg.mode)
+				for (uint i=0; i < NUM_OPERATORS; i += 4)
+				{
 					{
-						case EG_ATTACK:
+						const __m128i step = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pgPhase+i) );
+						const __m128i vibrato = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pgVibrato+i) );
+
+						const __m128i even = _mm_mul_epu32( step, multiplier );
+						const __m128i odd = _mm_mul_epu32( _mm_srli_epi64( step, 32 ), multiplier );
+
+						const __m128i modulated = _mm_srli_epi32
+						(
+							_mm_unpacklo_epi32
+							(
+								_mm_shuffle_epi32( even, _MM_SHUFFLE(3,1,2,0) ),
+								_mm_shuffle_epi32( odd, _MM_SHUFFLE(3,1,2,0) )
+							),
+							AMP_SHIFT
+						);
+
+						__m128i counter = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pgCounter+i) );
+						counter = _mm_add_epi32( counter, _mm_or_si128( _mm_and_si128( vibrato, modulated ), _mm_andnot_si128( vibrato, step ) ) );
+						_mm_storeu_si128( reinterpret_cast<__m128i*>(pgCounter+i), _mm_and_si128( counter, range ) );
+					}
 
-							egOut[i] = tables.GetLog( egOut[i] );
-							slots[i].eg.counter += slots[i].eg.phase;
+					{
+						const __m128i counter = _mm_loadu_si128( reinterpret_cast<const __m128i*>(egCounter+i) );
+						const __m128i next = _mm_add_epi32( counter, _mm_loadu_si128( reinterpret_cast<const __m128i*>(egPhase+i) ) );
+						const __m128i silent = _mm_loadu_si128( reinterpret_cast<const __m128i*>(egSilent+i) );
 
-							if (slots[i].eg.counter >= EG_BEGIN || (patch.tone[4+i] & REG45_ATTACK) == REG45_ATTACK)
-							{
-								egOut[i] = 0;
-								slots[i].eg.counter = 0;
-								slots[i].eg.mode = EG_DECAY;
-								UpdateEgPhase( tables, i );
-							}
-							break;
+						_mm_storeu_si128( reinterpret_cast<__m128i*>(egCounter+i), next );
+						_mm_storeu_si128( reinterpret_cast<__m128i*>(egOut+i), _mm_or_si128( _mm_and_si128( silent, end ), _mm_andnot_si128( silent, _mm_srli_epi32( counter, EG_PHASE_SHIFT ) ) ) );
 
-						case EG_DECAY:
-						{
-							slots[i].eg.counter += slots[i].eg.phase;
+						const __m128i limit = _mm_sub_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(egLimit+i) ), one );
+
+						events |= uint(_mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( next, limit ) ) )) << i;
+						attacking |= uint(_mm_movemask_ps( _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>(egAttack+i) ) ) )) << i;
+					}
+				}
 
-							dword level = patch.tone[6+i] & REG67_SUSTAIN_LEVEL;
+			#else
 
-							if (level == REG67_SUSTAIN_LEVEL)
-								level = SUSTAIN_LEVEL_MAX;
+				for (uint i=0; i < NUM_OPERATORS; ++i)
+				{
+					pgCounter[i] = (pgCounter[i] + ((pgPhase[i] * pitch >> AMP_SHIFT & pgVibrato[i]) | (pgPhase[i] & ~pgVibrato[i]))) & PG_PHASE_RANGE;
 
-							level <<= (EG_PHASE_SHIFT-1);
+					egOut[i] = egSilent[i] ? EG_END : egCounter[i] >> EG_PHASE_SHIFT;
+					egCounter[i] += egPhase[i];
 
-							if (slots[i].eg.counter >= level)
-							{
-								slots[i].eg.counter = level;
-								slots[i].eg.mode = (patch.tone[0+i] & REG01_HOLD) ? EG_HOLD : EG_SUSTAIN;
-								UpdateEgPhase( tables, i );
-							}
-							break;
-						}
+					events |= uint(egCounter[i] >= egLimit[i]) << i;
+					attacking |= (egAttack[i] & 1U) << i;
+				}
 
-						case EG_HOLD:
+			#endif
 
-							if (!(patch.tone[0+i] & REG01_HOLD))
-							{
-								slots[i].eg.mode = EG_SUSTAIN;
-								UpdateEgPhase( tables, i );
-							}
-							break;
+				return events;
+			}
 
-						case EG_SUSTAIN:
-						case EG_RELEASE:
+			inline void Vrc7::Sound::Operators::Attenuate(const uint amp)
+			{
+			#ifdef NST_VRC7_SSE2
 
-							slots[i].eg.counter += slots[i].eg.phase;
+				const __m128i modulation = _mm_set1_epi32( amp );
 
-							if (egOut[i] <= EG_END)
-								break;
+				for (uint i=0; i < NUM_OPERATORS; i += 4)
+				{
+					__m128i out = _mm_loadu_si128( reinterpret_cast<const __m128i*>(egOut+i) );
+					out = _mm_slli_epi32( _mm_add_epi32( out, _mm_loadu_si128( reinterpret_cast<const __m128i*>(tl+i) ) ), 1 );
+					out = _mm_add_epi32( out, _mm_and_si128( modulation, _mm_loadu_si128( reinterpret_cast<const __m128i*>(am+i) ) ) );
+					_mm_storeu_si128( reinterpret_cast<__m128i*>(egOut+i), out );
+				}
 
-							slots[i].eg.mode = EG_FINISH;
+			#else
 
-						default:
+				for (uint i=0; i < NUM_OPERATORS; ++i)
+					egOut[i] = (egOut[i] + tl[i]) * 2 + (amp & am[i]);
 
-							egOut[i] = EG_END;
-							break;
-					}
+			#endif
+			}
+
+			NST_FORCE_INLINE void Vrc7::Sound::OpllChannel::UpdateEgMode(const uint i,const Tables& tables)
+			{
+				NST_ASSERT( i < NUM_SLOTS );
+
+				switch (slots[i].eg.mode)
+				{
+					case EG_ATTACK:
+
+						operators->egOut[op+i] = 0;
+						operators->egCounter[op+i] = 0;
+						slots[i].eg.mode = EG_DECAY;
+						break;
+
+					case EG_DECAY:
+
+						operators->egCounter[op+i] = GetSustainLevel( i );
+						slots[i].eg.mode = (patch.tone[0+i] & REG01_HOLD) ? EG_HOLD : EG_SUSTAIN;
+						break;
+
+					case EG_HOLD:
+
+						slots[i].eg.mode = EG_SUSTAIN;
+						break;
+
+					case EG_SUSTAIN:
+					case EG_RELEASE:
+
+						operators->egOut[op+i] = EG_END;
+						slots[i].eg.mode = EG_FINISH;
+						break;
 
-					egOut[i] = (egOut[i] + slots[i].tl) * 2;
+					case EG_SETTLE:
+					case EG_FINISH:
 
-					if (patch.tone[i+0] & REG01_USE_AMP)
-						egOut[i] += amp;
+						// limited by EG_NEVER, never handed back here
+						break;
 				}
 
-				if (slots[CARRIER].eg.mode == EG_FINISH)
-					return 0;
+				UpdateEgPhase( tables, i );
+			}
+
+			NST_FORCE_INLINE Vrc7::Sound::Sample Vrc7::Sound::OpllChannel::GetSample(const Tables& tables)
+			{
+				const u32* const egOut = operators->egOut + op;
+				uint pgOut = operators->pgCounter[op+MODULATOR] >> PG_PHASE_SHIFT;
 
 				Sample output = slots[MODULATOR].output;
 
@@ -967,18 +1087,20 @@ namespace Nes
 				else
 				{
 					if (const uint fb = (patch.tone[3] & REG3_FEEDBACK))
-						pgOut[MODULATOR] = uint(int(pgOut[MODULATOR]) + sign_shr(feedback,FEEDBACK_SHIFT-fb)) & WAVE_RANGE;
+						pgOut = uint(int(pgOut) + sign_shr(feedback,FEEDBACK_SHIFT-fb)) & WAVE_RANGE;
 
-					slots[MODULATOR].output = tables.GetOutput( (patch.tone[3] & REG3_MODULATED_WAVE) >> 3, pgOut[MODULATOR], egOut[MODULATOR] );
+					slots[MODULATOR].output = tables.GetOutput( (patch.tone[3] & REG3_MODULATED_WAVE) >> 3, pgOut, egOut[MODULATOR] );
 				}
 
 				feedback = (output + slots[MODULATOR].output) / 2;
 				output = slots[CARRIER].output;
 
+				pgOut = operators->pgCounter[op+CARRIER] >> PG_PHASE_SHIFT;
+
 				if (egOut[CARRIER] >= EG_MUTE)
 					slots[CARRIER].output = 0;
 				else
-					slots[CARRIER].output = tables.GetOutput( (patch.tone[3] & REG3_CARRIER_WAVE) >> 4, uint(int(pgOut[CARRIER]) + feedback) & WAVE_RANGE, egOut[CARRIER] );
+					slots[CARRIER].output = tables.GetOutput( (patch.tone[3] & REG3_CARRIER_WAVE) >> 4, uint(int(pgOut) + feedback) & WAVE_RANGE, egOut[CARRIER] );
 
 				return (output + slots[CARRIER].output) / 2;
 			}
@@ -994,17 +1116,37 @@ namespace Nes
 						pitchPhase = (pitchPhase + PITCH_RATE) & PITCH_RANGE;
 						ampPhase = (ampPhase + AMP_RATE) & AMP_RANGE;
 
-						const uint lfo[2] =
+						// all twelve operators step their phase and envelope counters
+						// in one pass, only the envelopes that reached a limit on this
+						// clock go through the slower mode switch
+
+						uint attacking;
+						uint events = operators.Clock( tables.GetPitch( pitchPhase >> PITCH_SHIFT ), attacking );
+
+						for (uint i=0; attacking; ++i, attacking >>= 1)
+						{
+							if (attacking & 1U)
+								operators.egOut[i] = tables.GetLog( operators.egOut[i] );
+						}
+
+						for (uint i=0; events; ++i, events >>= 1)
 						{
-							tables.GetPitch( pitchPhase >> PITCH_SHIFT ),
-							tables.GetAmp( ampPhase >> AMP_SHIFT )
-						};
+							if (events & 1U)
+								channels[i / 2].UpdateEgMode( i % 2, tables );
+						}
+
+						operators.Attenuate( tables.GetAmp( ampPhase >> AMP_SHIFT ) );
 
 						prevSample = nextSample;
 						nextSample = 0;
 
+						// a finished carrier stays silent until the next key-on
+
 						for (uint i=0; i < NUM_OPLL_CHANNELS; ++i)
-							nextSample += channels[i].GetSample( lfo[0], lfo[1], tables );
+						{
+							if (!channels[i].IsFinished())
+								nextSample += channels[i].GetSample( tables );
+						}
 					}
 
 					samplePhase -= sampleRate;
@@ -1016,6 +1158,19 @@ namespace Nes
 					return 0;
 				}
 			}
+
+			Vrc7::Sound::Sample Vrc7::Sound::GetStems(Sample (&stems)[MAX_CHANNELS])
+			{
+				return stems[Apu::CHANNEL_VRC7] = GetSample();
+			}
+
+			Cycle Vrc7::Sound::Render(Sample* const output,const uint length,Cycle,Cycle,const Cycle next)
+			{
+				for (uint i=0; i < length; ++i)
+					output[i] = Sound::GetSample();
+
+				return next;
+			}
 		}
 	}
 }
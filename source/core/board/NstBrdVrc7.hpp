@@ -57,6 +57,8 @@ namespace Nes
 					void Reset();
 					void UpdateContext(uint,const u8 (&w)[MAX_CHANNELS]);
 					Sample GetSample();
+					Sample GetStems(Sample (&)[MAX_CHANNELS]);
+					Cycle Render(Sample*,uint,Cycle,Cycle,Cycle);
 
 				private:
 
@@ -123,7 +125,33 @@ namespace Nes
 
 					enum
 					{
-						NUM_OPLL_CHANNELS = 6
+						NUM_OPLL_CHANNELS = 6,
+						NUM_OPERATORS = NUM_OPLL_CHANNELS * 2
+					};
+
+					struct Operators
+					{
+						void Reset();
+
+						inline uint Clock(uint,uint&);
+						inline void Attenuate(uint);
+
+						enum
+						{
+							EG_NEVER = 0x7FFFFFFF
+						};
+
+						u32 pgCounter[NUM_OPERATORS];
+						u32 pgPhase[NUM_OPERATORS];
+						u32 pgVibrato[NUM_OPERATORS];
+						u32 egCounter[NUM_OPERATORS];
+						u32 egPhase[NUM_OPERATORS];
+						u32 egLimit[NUM_OPERATORS];
+						u32 egAttack[NUM_OPERATORS];
+						u32 egSilent[NUM_OPERATORS];
+						u32 egOut[NUM_OPERATORS];
+						u32 tl[NUM_OPERATORS];
+						u32 am[NUM_OPERATORS];
 					};
 
 					class OpllChannel
@@ -132,6 +160,7 @@ namespace Nes
 
 						OpllChannel();
 
+						void Connect(Operators&,uint);
 						void Reset();
 						void Update(const Tables&);
 						void SaveState(State::Saver&) const;
@@ -149,7 +178,13 @@ namespace Nes
 						NST_FORCE_INLINE void WriteReg9 (uint,const Tables&);
 						NST_FORCE_INLINE void WriteRegA (uint,const Tables&);
 
-						NST_FORCE_INLINE Sample GetSample(uint,uint,const Tables&);
+						NST_FORCE_INLINE void UpdateEgMode(uint,const Tables&);
+						NST_FORCE_INLINE Sample GetSample(const Tables&);
+
+						bool IsFinished() const
+						{
+							return slots[CARRIER].eg.mode == EG_FINISH;
+						}
 
 					private:
 
@@ -158,6 +193,8 @@ namespace Nes
 						void UpdateTotalLevel   (const Tables&,uint);
 						void UpdateEgPhase      (const Tables&,uint);
 
+						dword GetSustainLevel(uint) const;
+
 						enum Mode
 						{
 							EG_SETTLE,
@@ -217,19 +254,9 @@ namespace Nes
 							struct Eg
 							{
 								Mode mode;
-								dword phase;
-								dword counter;
-							};
-
-							struct Pg
-							{
-								dword phase;
-								dword counter;
 							};
 
-							Pg pg;
 							Eg eg;
-							uint tl;
 							uint sl;
 							Sample output;
 						};
@@ -242,6 +269,8 @@ namespace Nes
 						Patch patch;
 						Slot slots[NUM_SLOTS];
 						Sample feedback;
+						Operators* operators;
+						uint op;
 					};
 
 					Apu& apu;
@@ -255,6 +284,7 @@ namespace Nes
 					Sample prevSample;
 					Sample nextSample;
 
+					Operators operators;
 					OpllChannel channels[NUM_OPLL_CHANNELS];
 					const Tables tables;
 
@@ -59,7 +59,12 @@ namespace Nes
 				stream = 0xFF;
 				state = 0;
 				timeStamp = 0;
-				mic = 0;
+
+				// shared by every pad, only cleared when set so machines
+				// that never see a mic can run on other threads side by side
+
+				if (mic)
+					mic = 0;
 			}
 
 			void Pad::SaveState(State::Saver& state,const uchar id) const
@@ -92,7 +97,9 @@ namespace Nes
 			void Pad::BeginFrame(Controllers* i)
 			{
 				input = i;
-				mic = 0;
+
+				if (mic)
+					mic = 0;
 
 				if (timeStamp)
 					--timeStamp;
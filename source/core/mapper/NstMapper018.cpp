@@ -316,6 +316,11 @@ namespace Nes
 			return (count & mask) && !(--count & mask);
 		}
 
+		dword Mapper18::Irq::NextSignal() const
+		{
+			return count & mask;
+		}
+
 		void Mapper18::VSync()
 		{
 			irq.VSync();
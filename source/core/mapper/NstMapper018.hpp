@@ -101,6 +101,7 @@ namespace Nes
 			{
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				uint mask;
 				uint count;
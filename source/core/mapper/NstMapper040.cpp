@@ -109,6 +109,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper40::Irq::NextSignal() const
+		{
+			return enabled ? 0x1000U - (count & 0xFFFU) : 0;
+		}
+
 		NES_PEEK(Mapper40,6000)
 		{
 			return *prg.Source().Mem( (SIZE_64K-SIZE_16K-0x6000U) + address );
@@ -55,6 +55,7 @@ namespace Nes
 			{
 				void Reset(bool=true);
 				ibool Signal();
+				dword NextSignal() const;
 
 				ibool enabled;
 				uint count;
@@ -128,6 +128,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper42::Irq::NextSignal() const
+		{
+			return 0x2000U - (count & 0x1FFFU);
+		}
+
 		void Mapper42::VSync()
 		{
 			irq.VSync();
@@ -138,6 +138,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper43::Irq::NextSignal() const
+		{
+			return enabled ? 0x1000U - (count & 0xFFFU) : 0;
+		}
+
 		NES_POKE(Mapper43,4022)
 		{
 			static const u8 banks[8] = {4,3,4,4,4,7,5,6};
@@ -117,6 +117,11 @@ namespace Nes
 			return ++count == 0x1000U;
 		}
 
+		dword Mapper50::Irq::NextSignal() const
+		{
+			return dword(0x1000U - count);
+		}
+
 		void Mapper50::VSync()
 		{
 			irq.unit.count = 0;
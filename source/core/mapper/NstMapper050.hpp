@@ -54,6 +54,7 @@ namespace Nes
 			{
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				uint count;
 			};
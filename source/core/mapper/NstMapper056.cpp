@@ -210,6 +210,11 @@ namespace Nes
 			return true;
 		}
 
+		dword Mapper56::Irq::NextSignal() const
+		{
+			return dword(0x10000UL - count);
+		}
+
 		void Mapper56::VSync()
 		{
 			irq.VSync();
@@ -59,6 +59,7 @@ namespace Nes
 			{
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				uint count;
 				uint latch;
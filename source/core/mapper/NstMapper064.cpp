@@ -193,6 +193,18 @@ namespace Nes
 			}
 		}
 
+		dword Mapper64::Irq::Unit::NextSignal() const
+		{
+			if (!enabled)
+				return 0;
+			else if (reload)
+				return latch + 2;
+			else if (count)
+				return count;
+			else
+				return latch ? latch + 1 : 0;
+		}
+
 		void Mapper64::Irq::Update()
 		{
 			a12.Update();
@@ -84,6 +84,7 @@ namespace Nes
 				{
 					void Reset(bool=true);
 					ibool Signal();
+					dword NextSignal() const;
 
 					uint count;
 					uint latch;
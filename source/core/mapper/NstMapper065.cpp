@@ -150,6 +150,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper65::Irq::NextSignal() const
+		{
+			return (enabled && count) ? count : 0;
+		}
+
 		void Mapper65::VSync()
 		{
 			irq.VSync();
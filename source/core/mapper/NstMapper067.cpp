@@ -128,6 +128,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper67::Irq::NextSignal() const
+		{
+			return (enabled && count) ? count : 0;
+		}
+
 		void Mapper67::VSync()
 		{
 			irq.VSync();
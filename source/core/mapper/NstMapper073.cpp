@@ -109,6 +109,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper73::Irq::NextSignal() const
+		{
+			return enabled ? 0x10000UL - (count & 0xFFFFU) : 0;
+		}
+
 		NES_POKE(Mapper73,8000)
 		{
 			irq.Update();
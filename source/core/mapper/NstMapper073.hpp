@@ -57,6 +57,7 @@ namespace Nes
 			{
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				ibool enabled;
 				uint count;
@@ -306,6 +306,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper83::Irq::NextSignal() const
+		{
+			return (enabled && count) ? (step == 1 ? 0x10000UL - count : count) : 0;
+		}
+
 		void Mapper83::VSync()
 		{
 			irq.VSync();
@@ -70,6 +70,7 @@ namespace Nes
 			{
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				ibool enabled;
 				uint count;
@@ -108,6 +108,11 @@ namespace Nes
 			return (enabled && count && !--count);
 		}
 
+		dword Mapper117::Irq::NextSignal() const
+		{
+			return enabled ? count : 0;
+		}
+
 		NES_POKE(Mapper117,C001)
 		{
 			irq.Update();
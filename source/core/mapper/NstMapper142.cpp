@@ -169,6 +169,11 @@ namespace Nes
 			return false;
 		}
 
+		dword Mapper142::Irq::NextSignal() const
+		{
+			return enabled ? dword(0x10000UL - count) : 0;
+		}
+
 		void Mapper142::VSync()
 		{
 			irq.VSync();
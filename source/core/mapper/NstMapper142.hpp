@@ -58,6 +58,7 @@ namespace Nes
 			{
 				void Reset(bool);
 				ibool Signal();
+				dword NextSignal() const;
 
 				ibool enabled;
 				uint count;
@@ -123,6 +123,14 @@ namespace Nes
 			return enabled && (++count[1] & 0xFF) == 0;
 		}
 
+		dword Mapper183::Irq::NextSignal() const
+		{
+			if (!enabled)
+				return 0;
+
+			return (count[0] < 114 ? 114 - count[0] : 1) + (0xFFU - (count[1] & 0xFF)) * 114UL;
+		}
+
 		NES_POKE(Mapper183,B000) { ppu.Update(); chr.SwapBank<SIZE_1K,0x0000U>( (chr.GetBank<SIZE_1K,0x0000U>() & 0xF0) | ((data & 0xF) << 0) ); }
 		NES_POKE(Mapper183,B004) { ppu.Update(); chr.SwapBank<SIZE_1K,0x0000U>( (chr.GetBank<SIZE_1K,0x0000U>() & 0x0F) | ((data & 0xF) << 4) ); }
 		NES_POKE(Mapper183,B008) { ppu.Update(); chr.SwapBank<SIZE_1K,0x0400U>( (chr.GetBank<SIZE_1K,0x0400U>() & 0xF0) | ((data & 0xF) << 0) ); }
@@ -95,6 +95,16 @@ namespace Nes
 			return true;
 		}
 
+		dword Mapper222::Irq::NextSignal() const
+		{
+			if (!count)
+				return 0;
+			else if (count < 240)
+				return 240 - count;
+			else
+				return 1;
+		}
+
 		NES_POKE(Mapper222,F000)
 		{
 			irq.Update();